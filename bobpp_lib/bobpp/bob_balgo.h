@@ -10,6 +10,7 @@
 
 #include <string>
 #include <time.h>
+#include <vector>
 
 namespace Bob {
 
@@ -71,6 +72,18 @@ public:
   virtual ~base_Node() {
     DBGAFF_MEM("base_Node::~base_Node", "Destructor");
   }
+  /** allocation of a node, the node is allocated by the Bob::NodePool.
+    * @param sz the size of the node
+    */
+  static void *operator new(size_t sz) {
+    return NodePool::alloc(sz);
+  }
+  /** deallocation of a node allocated by the Bob::NodePool
+    * @param p the node to release
+    */
+  static void operator delete(void *p) {
+    NodePool::release(p);
+  }
   /** copy method used by the operator=
     * @param bn the source node.
     */
@@ -170,6 +183,153 @@ public:
     bs.UnPack(&d, 1);
     bs.UnPack(&nid, 1);
   }
+  /** Pack method used by the priority queues that store the nodes in a 
+    * packed form (Bob::PQCompact and Bob::PQSpill).
+    * By default the node is packed with the Pack method, a node could redefine 
+    * this method to use a smaller representation (variable width integers, 
+    * only the fixed part of a permutation...). The reference counter
+    * does not need to be stored.
+    * @param bs the Serialize object
+    */
+  virtual void PackQ(Serialize &bs)  const {
+    Pack(bs);
+  }
+  /** Unpack method for the nodes packed with the PackQ method.
+    * The reference counter of the unpacked node is set to 0.
+    * @param bs the DeSerialize object
+    */
+  virtual void UnPackQ(DeSerialize &bs)  {
+    UnPack(bs);
+    _ref = 0;
+  }
+};
+
+/**
+ * The NodePath class stores the path from the root node to a node as the list of the
+ * branching decisions.
+ * When a child differs from its parent by one decision, a node could store a NodePath
+ * instead of its complete state (a permutation, a partial solution...).
+ * Each decision is stored in a small immutable link that also points to the link of the
+ * parent. A child that copies the path of its parent and adds one decision only
+ * allocates one link, and all the ancestor links are shared.
+ * As for the base_Node, each link has a reference counter, the links are released when
+ * the last node that uses them is deleted.
+ * The state of the node is materialized with the get() method, when the node is expanded.
+ * The links are allocated by the Bob::NodePool.
+ * @param Dec the type of a decision (an integral type).
+ */
+template <class Dec>
+class NodePath {
+  /// a link of the path
+  struct Link {
+    /// the link of the parent
+    Link *par;
+    /// the decision
+    Dec dec;
+    /// the reference counter
+    int ref;
+    /// the length of the path from the root
+    int len;
+    /// Constructor
+    Link(Link *p, const Dec &d) : par(p), dec(d), ref(1), len(p == 0 ? 1 : p->len + 1) {}
+    /// allocation of a link
+    static void *operator new(size_t sz) {
+      return NodePool::alloc(sz);
+    }
+    /// deallocation of a link
+    static void operator delete(void *p) {
+      NodePool::release(p);
+    }
+  };
+  /// the last link of the path
+  Link *l;
+  /// releases the reference on the path
+  void release() {
+    while (l != 0 && __sync_sub_and_fetch(&(l->ref), 1) == 0) {
+      Link *p = l->par;
+      delete l;
+      l = p;
+    }
+    l = 0;
+  }
+public:
+  /** Constructor of an empty path
+    */
+  NodePath() : l(0) {}
+  /** Constructor
+    * @param np the path to share
+    */
+  NodePath(const NodePath &np) : l(np.l) {
+    if (l != 0) __sync_add_and_fetch(&(l->ref), 1);
+  }
+  /// Destructor
+  ~NodePath() {
+    release();
+  }
+  /** copy method
+    * @param np the path to share
+    */
+  void copy(const NodePath &np) {
+    if (np.l != 0) __sync_add_and_fetch(&(np.l->ref), 1);
+    release();
+    l = np.l;
+  }
+  /** operator =
+    * @param np the path to share
+    */
+  NodePath &operator=(const NodePath &np) {
+    copy(np);
+    return *this;
+  }
+  /** Adds a decision at the end of the path
+    * @param d the decision
+    */
+  void push(const Dec &d) {
+    l = new Link(l, d);
+  }
+  /** Get the number of decisions of the path
+    */
+  int size() const {
+    return (l == 0 ? 0 : l->len);
+  }
+  /** Get the last decision of the path
+    */
+  const Dec &last() const {
+    return l->dec;
+  }
+  /** Get all the decisions of the path
+    * @param t an array of size() decisions filled from the root to the node.
+    * @return the number of decisions
+    */
+  int get(Dec *t) const {
+    int n = size();
+    for (Link *c = l; c != 0; c = c->par) t[c->len - 1] = c->dec;
+    return n;
+  }
+  /** Pack method to serialize the path
+    * the decisions are packed, the unpacked path is not shared.
+    * @param bs the Serialize object
+    */
+  void Pack(Serialize &bs) const {
+    int n = size();
+    Bob::Pack(bs, &n, 1);
+    if (n > 0) {
+      std::vector<Dec> t(n);
+      get(&t[0]);
+      Bob::Pack(bs, &t[0], n);
+    }
+  }
+  /** Unpack method to deserialize the path
+    * @param bs the DeSerialize object
+    */
+  void UnPack(DeSerialize &bs) {
+    int n;
+    release();
+    Bob::UnPack(bs, &n, 1);
+    std::vector<Dec> t(n);
+    if (n > 0) Bob::UnPack(bs, &t[0], n);
+    for (int i = 0; i < n; i++) push(t[i]);
+  }
 };
 
 /**
@@ -250,6 +410,8 @@ public:
 private:
 };
 
+class TreeProfile;
+
 /**
  * The StatAlgo class is the basic class that stores the statitics
  * associated with the algorithm at this stage of the definition of
@@ -269,13 +431,19 @@ public:
   /// Destructor
   virtual ~base_Stat() { }
   /// Starts the time execution
-  void start() {
+  virtual void start() {
     get_timer('T').start();
   }
   /// Ends the time execution
-  void end() {
+  virtual void end() {
     get_timer('T').end();
   }
+  /** get the profile of the explored tree (see TreeProfile)
+    * @return 0 if the algorithm does not profile the tree
+    */
+  virtual const TreeProfile *profile() const {
+    return 0;
+  }
   /** method to log a node creation.
     * @param bn the created node
     * @param pn the parent node of bn
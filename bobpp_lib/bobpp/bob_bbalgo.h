@@ -298,13 +298,31 @@ public :
  * The Branch and Bound statistics adds a timer to measure the evaluation time of the nodes.
  */
 class BBStat : public SchedStat {
+  /// number of nodes allocated by the thread at the start of the algorithm
+  long long nba;
+  /// number of bytes allocated by the thread at the start of the algorithm
+  long long nbb;
 public:
   /// Constructor
-  BBStat(const Id &s) : SchedStat('B', s) {
+  BBStat(const Id &s) : SchedStat('B', s), nba(0), nbb(0) {
     add_timer('E', "time for node Evaluation");
+    add_counter('a', "Allocated nodes");
+    add_counter('b', "Allocated Kbytes");
   }
   /// Destructor
   virtual ~BBStat() {}
+  /// Starts the time execution and the count of the allocations.
+  virtual void start() {
+    SchedStat::start();
+    nba = NodePool::nb_alloc();
+    nbb = NodePool::nb_bytes();
+  }
+  /// Ends the time execution and adds the allocations done by the thread.
+  virtual void end() {
+    get_counter('a').add(NodePool::nb_alloc() - nba);
+    get_counter('b').add((NodePool::nb_bytes() - nbb) / 1024);
+    SchedStat::end();
+  }
   /** start the time for evaluated node
     * @param bn the child node.
     * @param pn the parent node
@@ -337,6 +355,8 @@ public:
 /** The Branch and Bound GenChild
   * This class is just for naming convention coherency since the BobBBGenChild class is exactly the same 
 as the Bob::SchedGenChild.
+  * The sibling nodes given to the Search() method during a call to the operator() are 
+  * buffered by the algorithm and inserted at once in the priority queue (see PQInterface::InsBatch()).
  */
 template <class Trait>
 class BBGenChild : public SchedGenChild<Trait> {
@@ -385,33 +405,70 @@ public :
 protected:
   /// the solution
   TheNode *sol;
+  /// the key of the solution (see Eval::pri_key())
+  volatile double solk;
+  /** the key used to prune the nodes, the best of the key of the solution and
+    * of the keys of the solutions found by other processes (see update_key()),
+    * read without lock by isClosed()
+    */
+  volatile double inck;
+  /** set the solution and its key
+    * @param n the new solution
+    */
+  void set_sol(TheNode *n) {
+    sol = n;
+    solk = (n == 0 ? HUGE_VAL : n->pri_key());
+    min_key(&inck, solk);
+  }
+  /** lower atomically a key.
+    * @param p the key to modify
+    * @param k the new value
+    * @return true if the key is lowered
+    */
+  static bool min_key(volatile double *p, double k) {
+    union { double d; long long l; } o, v;
+    v.d = k;
+    do {
+      o.d = *p;
+      if (!(k < o.d)) return false;
+    } while (!__sync_bool_compare_and_swap((volatile long long *)p, o.l, v.l));
+    return true;
+  }
+  /** get the tolerance given by the --bb -gap and --bb -agap options.
+    * @param k the key of the solution
+    * @return the maximum difference between the key of the solution and the key of a node to prune it
+    */
+  static double tolerance(double k) {
+    double r = core::get_gap() * fabs(k);
+    return (r > core::get_agap() ? r : core::get_agap());
+  }
 public:
   /** Constructor
     * @param l a bool if true the stat of the goal are logged.
     */
-  BBGoalBest(bool l=false): SchedGoal<Trait>(l), sol(0) { }
+  BBGoalBest(bool l=false): SchedGoal<Trait>(l), sol(0), solk(HUGE_VAL), inck(HUGE_VAL) { }
   /** Constructor
     * @param id the algorithm identifier
     * @param l a bool if true the stat of the goal are logged.
     */
-  BBGoalBest(const Id &id,bool l=false): SchedGoal<Trait>(id,l), sol(0) { }
+  BBGoalBest(const Id &id,bool l=false): SchedGoal<Trait>(id,l), sol(0), solk(HUGE_VAL), inck(HUGE_VAL) { }
   /** Constructor
     * @param bb the source goal
     */
-  BBGoalBest(BBGoalBest<Trait> &bb): SchedGoal<Trait>(bb), sol(0) {
+  BBGoalBest(BBGoalBest<Trait> &bb): SchedGoal<Trait>(bb), sol(0), solk(HUGE_VAL), inck(bb.inck) {
     //std::cout << "BBGoalBest Copy &bb\n";
     if (bb.sol != 0) {
-      sol = bb.sol;
+      set_sol(bb.sol);
       sol->addRef();
     }
   }
   /** Constructor
     * @param bb the source goal
     */
-  BBGoalBest(const BBGoalBest<Trait> &bb): SchedGoal<Trait>(bb), sol(0) {
+  BBGoalBest(const BBGoalBest<Trait> &bb): SchedGoal<Trait>(bb), sol(0), solk(HUGE_VAL), inck(bb.inck) {
     //std::cout << "BBGoalBest Copy const &bb\n";
     if (bb.sol != 0) {
-      sol = bb.sol;
+      set_sol(bb.sol);
       sol->addRef();
     }
   }
@@ -429,12 +486,60 @@ public:
     if (sol == 0) return 0;
     return sol->getEval();
   }
+  /** Write the metrics of the goal and the value of the incumbent.
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) {
+    SchedGoal<Trait>::Metrics(os);
+    if (sol != 0) os << " inc=" << sol->getEval();
+  }
+  /** Write the bound of the search and the relative gap with the solution.
+    * @param os the std::ostream used to write the metrics
+    * @param bk the bound of the search as a key (see PQInterface::BestKey())
+    */
+  virtual void MetricsBound(std::ostream &os, double bk) {
+    if (bk == HUGE_VAL || bk == -HUGE_VAL) return;
+    typename TheNode::ThisEval one((TheType)1);
+    os << " bound=" << bk * one.pri_key();
+    double k = inck;
+    if (k != HUGE_VAL) os << " gap=" << (k - bk) / (k != 0 ? fabs(k) : 1.0);
+  }
+  /** Test if the bound is close enough to the solution (see the --bb -gap and --bb -agap options).
+    * @param bk the bound of the search as a key (see PQInterface::BestKey())
+    */
+  virtual bool isClosed(double bk) {
+    double k = inck;
+    if (k == HUGE_VAL || bk == -HUGE_VAL) return false;
+    return k - bk <= tolerance(k);
+  }
+  /** Get the key used to prune the nodes.
+    */
+  virtual double inc_key() {
+    return inck;
+  }
+  /** Tighten the key used to prune the nodes with the key of a solution found elsewhere.
+    * @param k the key of the solution
+    */
+  virtual bool update_key(double k) {
+    return min_key(&inck, k);
+  }
+  /** Test without lock if the node is pruned by the key of the incumbent.
+    * @param n the node to test
+    */
+  virtual bool is_pruned(TheNode *n) {
+    return isClosed(n->pri_key());
+  }
+  /** Test if the solution is the one of the key used to prune the nodes.
+    */
+  virtual bool holds_inc() {
+    return sol != 0 && solk <= inck;
+  }
   /** Intialize the Goal with the given instance.
     * @param ti the instance.
     * Mainly this method call the BBInstance::getSol() method to get the incubent.
     */
   virtual void Init(TheInstance *ti) {
-    sol = ti->getSol();
+    set_sol(ti->getSol());
     //std::cout << "Node Sol:"<<*sol<<std::endl;
     sol->addRef();
   }
@@ -454,7 +559,7 @@ public:
         delete sol;
 	}
       if ( u==0 ) SchedGoal<Trait>::stat_upd(n);
-      sol = n;
+      set_sol(n);
       sol->addRef();
       if (core::dispBestVal() && u == 0 && SchedGoal<Trait>::verbosity() )
         std::cout << core::dTime() << " Solution: " << n << std::flush;
@@ -464,9 +569,16 @@ public:
   }
 
   /** Method to test if the node is suitable to be explore later.
+    * The node must be better than the solution, and than the solutions found
+    * by the other processes (see update_key()). With the --bb -gap or --bb -agap
+    * options, it must be better by more than the tolerance.
     * @param n the node to test
     */
   virtual bool is4Search(TheNode *n) {
+    if (is_pruned(n)) {
+      DBGAFF_ALGO("BBGoalBest::is4Search()", "Node must be pruned");
+      return false;
+    }
     if (sol == 0) {
       DBGAFF_ALGO("BBGoalBest::is4Search()", "Node is ok, no solution");
       return true;
@@ -540,12 +652,13 @@ public:
     SchedGoal<Trait>::UnPack(bs);
     bs.UnPack(&i, 1);
     if (i == 0) {
-      sol = 0;
+      set_sol(0);
       //std::cout <<" UnPack no sol\n";
       return;
     }
     sol = new TheNode();
     sol->UnPack(bs);
+    set_sol(sol);
     sol->Prt(std::cout);
   }
 
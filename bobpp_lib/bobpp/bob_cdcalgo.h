@@ -433,7 +433,7 @@ public:
     //std::cout << "CDCGoalBest current_merge\n";
     if (_tg == 0) return false;
     if (_tg->sol == 0) return false;
-    return update(_tg->sol,1);
+    return TheGoal::update(_tg->sol,1);
   }
   /** the merging method is used to update the goal with another one.
     * this method is used in distributed environment.
@@ -443,7 +443,7 @@ public:
     //std::cout << "CDCGoalBest final_merge\n ";
     if (_tg == 0) return false;
     if (_tg->sol == 0) return false;
-    return update(_tg->sol,1);
+    return TheGoal::update(_tg->sol,1);
   }
 
   /** Return the best known solution */
@@ -49,9 +49,24 @@ long core::reft;
 double core::reftd;
 int core::btdthreshold;
 int core::depth_rec;
+int core::local_dive;
+int core::local_batch;
+std::string core::pq_type = "hn";
+double core::bucket_q = 1.0;
+int core::spill_max = 1000000;
+std::string core::spill_dir = "/tmp";
+int core::compact_max = 100000;
+bool core::sys_alloc = false;
 long core::time_limt;
 node_id core::nid = 1;
 bool core::dispbestval = false;
+bool core::histo = false;
+std::string core::metrics_file = "";
+double core::metrics_period = 1.0;
+int core::metrics_rot = 16;
+double core::gap_rel = 0.0;
+double core::gap_abs = 0.0;
+double core::ft_period = 0.0;
 BaseAlgoEnvProg *core::env_prog=0;
 
 /*------------------ Core methods ----------------------*/
@@ -66,8 +81,22 @@ void core::Config(int n, char **v) {
   opt().add(std::string("--"), Property("-of", "log output file", "file.log", &logfile));
   opt().add(std::string("--"), Property("-sp", "log the space search", &spacesearch));
   opt().add(std::string("--"), Property("-s", "display current best solution", &dispbestval));
+  opt().add(std::string("--"), Property("-sh", "display the log-scale histograms of the timers and of the lock waits", &histo));
   opt().add(std::string("--"), Property("-tl", "time limt", -1, (int *)&time_limt));
   opt().add(std::string("--"), Property("-dr", "depth to pass to recursive search", 10, (int *)&depth_rec));
+  opt().add(std::string("--"), Property("-ld", "size of the local stack for the local dive (0=no local dive)", 0, (int *)&local_dive));
+  opt().add(std::string("--"), Property("-ldb", "number of nodes deleted at once from the GPQ to refill the local stack of the local dive", 4, (int *)&local_batch));
+  opt().add(std::string("--"), Property("-pq", "priority queue of the sequential B&B (hn=n-heap, hk=n-heap with keys, bk=buckets, sp=spill to disk, cp=compact)", "hn", &pq_type));
+  opt().add(std::string("--"), Property("-bq", "quantum of the keys for the bucket priority queue", 1.0, &bucket_q));
+  opt().add(std::string("--"), Property("-spm", "maximum number of nodes in memory for the spill priority queue", 1000000, &spill_max));
+  opt().add(std::string("--"), Property("-spd", "directory of the files of the spill priority queue", "/tmp", &spill_dir));
+  opt().add(std::string("--"), Property("-cpm", "maximum number of unpacked nodes for the compact priority queue", 100000, &compact_max));
+  opt().add(std::string("--"), Property("-sa", "use the system allocator for the nodes (no node pool)", &sys_alloc));
+  opt().add(std::string("--"), Property("-mf", "file where the metrics are written during the search (unix:path for a Unix socket, empty for no metrics)", "", &metrics_file));
+  opt().add(std::string("--"), Property("-mp", "period in seconds of the metrics", 1.0, &metrics_period));
+  opt().add(std::string("--"), Property("-mr", "maximum size in Mbytes of the metrics file before its rotation (0=no rotation)", 16, &metrics_rot));
+  opt().add(std::string("--bb"), Property("-gap", "relative gap between the best solution and the bound to end the search (0=optimal)", 0.0, &gap_rel));
+  opt().add(std::string("--bb"), Property("-agap", "absolute gap between the best solution and the bound to end the search (0=optimal)", 0.0, &gap_abs));
 #ifndef WIN32
   opt().add(std::string("--"), Property("-ln", "log to network host"));
   opt().add(std::string("--"), Property("-on", "log network host, format = address[:port]", "localhost:2222"));
@@ -75,6 +104,7 @@ void core::Config(int n, char **v) {
 #ifdef BOBPP_ENABLE_FT
   opt().add(std::string("--"), Property("-ft_file", "file to store", "bobpp.store"));
   opt().add(std::string("--"), Property("-ft_rs", "restoring from file"));
+  opt().add(std::string("--"), Property("-ft_period", "period in seconds of the background checkpoints (0=no checkpoint)", 0.0, &ft_period));
 #endif
   debug_config::opt();
   opt().parse(n, v);
@@ -136,6 +166,7 @@ void core::End() {
   double t=dTime();
   std::cout << "Core Time :"<< t << std::endl;
   opt().clear();
+  NodePool::reclaim();
 }
 
 long core::Time(long b) {
@@ -149,6 +180,19 @@ double core::dTime(double b) {
   double d = t.tv_sec + 1e-6 * t.tv_usec;
   return d -(reftd + b);
 }
+double core::mTime() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+long core::rss() {
+  long sz = 0, res = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f == 0) return 0;
+  if (fscanf(f, "%ld %ld", &sz, &res) != 2) res = 0;
+  fclose(f);
+  return res * (sysconf(_SC_PAGESIZE) / 1024);
+}
 string core::sTime(long b) {
   char buf[120];
   sprintf(buf, "%02ldh:%02ldm:%02lds", b / (3600), (b / 60) % 60, b % 60);
@@ -62,12 +62,42 @@ protected:
   static int btdthreshold;
   /// threshold to pass to recursive mode
   static int depth_rec;
+  /// size of the local stack used by the local dive (0 no local dive)
+  static int local_dive;
+  /// number of nodes deleted at once from the GPQ to refill the local stack
+  static int local_batch;
+  /// the priority queue used by the sequential environment
+  static std::string pq_type;
+  /// the quantum of the keys for the bucket priority queue
+  static double bucket_q;
+  /// the maximum number of nodes in memory for the spill priority queue
+  static int spill_max;
+  /// the directory of the files of the spill priority queue
+  static std::string spill_dir;
+  /// the maximum number of unpacked nodes of the compact priority queue
+  static int compact_max;
+  /// use the system allocator for the nodes instead of the node pool
+  static bool sys_alloc;
   /// Time limt of the application.
   static long time_limt;
   /// the node identifier
   static node_id nid;
   /// display the value of the current best solution
   static bool dispbestval;
+  /// display the histograms of the timers
+  static bool histo;
+  /// the destination of the metrics
+  static std::string metrics_file;
+  /// the period of the metrics
+  static double metrics_period;
+  /// the maximum size in Mbytes of the metrics file
+  static int metrics_rot;
+  /// the relative gap between the best solution and the bound to end the search
+  static double gap_rel;
+  /// the absolute gap between the best solution and the bound to end the search
+  static double gap_abs;
+  /// the period in seconds of the background checkpoints
+  static double ft_period;
   /// the primary environment
   static BaseAlgoEnvProg *env_prog;
 public:
@@ -89,11 +119,75 @@ public:
   static int get_depth_rec() {
     return depth_rec;
   }
+  /// method to get the size of the local stack used by the local dive
+  static int get_local_dive() {
+    return local_dive;
+  }
+  /// method to get the number of nodes deleted at once from the GPQ to refill the local stack
+  static int get_local_batch() {
+    return local_batch;
+  }
+  /// method to get the type of the priority queue used by the sequential environment
+  static const std::string &get_pq_type() {
+    return pq_type;
+  }
+  /// method to get the quantum of the keys for the bucket priority queue
+  static double get_bucket_q() {
+    return bucket_q;
+  }
+  /// method to get the maximum number of nodes in memory for the spill priority queue
+  static long get_spill_max() {
+    return spill_max;
+  }
+  /// method to get the directory of the files of the spill priority queue
+  static const std::string &get_spill_dir() {
+    return spill_dir;
+  }
+  /// method to get the maximum number of unpacked nodes of the compact priority queue
+  static long get_compact_max() {
+    return compact_max;
+  }
+  /// method to know if the nodes are allocated by the node pool
+  static bool node_pool() {
+    return !sys_alloc;
+  }
 
   /// if we need to display the best value at each goal update
   static bool dispBestVal() {
     return dispbestval;
   }
+  /// if we need to display the histograms of the timers
+  static bool disp_histo() {
+    return histo;
+  }
+  /// method to get the destination of the metrics (empty for no metrics)
+  static const std::string &get_metrics_file() {
+    return metrics_file;
+  }
+  /// method to get the period of the metrics
+  static double get_metrics_period() {
+    return metrics_period;
+  }
+  /// method to get the maximum size in bytes of the metrics file
+  static long get_metrics_rot() {
+    return metrics_rot * 1024L * 1024L;
+  }
+  /// method to get the relative gap to end the search
+  static double get_gap() {
+    return gap_rel;
+  }
+  /// method to get the absolute gap to end the search
+  static double get_agap() {
+    return gap_abs;
+  }
+  /// method to get the period in seconds of the background checkpoints (0 for no checkpoint)
+  static double get_ft_period() {
+    return ft_period;
+  }
+  /// if the search ends at a given gap
+  static bool use_gap() {
+    return gap_rel > 0 || gap_abs > 0;
+  }
   /// if we need to log the space search (display the node identifier and their hierarchy 
   static bool space_search() {
     return spacesearch;
@@ -125,6 +219,12 @@ public:
   static long Time(long b = 0);
   /// static method to get the time in seconds with microsecond precision
   static double dTime(double b = 0.0);
+  /** static method to get the time in seconds of a monotonic clock (the origin is unspecified),
+    * used to measure the durations.
+    */
+  static double mTime();
+  /// static method to get the resident memory of the process in Kbytes
+  static long rss();
   /// static method to get the time in a human redable way
   static std::string sTime(long b);
   /// static method to get a node identifier
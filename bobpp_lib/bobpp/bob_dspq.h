@@ -10,6 +10,13 @@
 #ifndef DSPQ_HEADER
 #define DSPQ_HEADER
 
+#include <deque>
+#include <cmath>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /*----------- Set of Nodes ----------*/
 
 namespace  Bob {
@@ -64,6 +71,12 @@ public:
     get_counter('i')++;
     //get_counter("l")+=l;
   }
+  /** Method to count the insertion of several nodes
+    * @param nb the number of node inserted
+    */
+  virtual void InsN(int nb) {
+    get_counter('i') += nb;
+  }
   /** Method to count the number of delete
     * @param l the number of node inserted
     */
@@ -71,6 +84,12 @@ public:
     get_counter('d')++;
     //get_counter("l")-=l;
   }
+  /** Method to count the deletion of several nodes
+    * @param nb the number of node deleted
+    */
+  virtual void DelN(int nb) {
+    get_counter('d') += nb;
+  }
   /** Method to count the number of delete greater operation
     * @param nb the number of node inserted
     */
@@ -83,6 +102,12 @@ public:
   int GetNbN() {
     return get_counter('i').get() - get_counter('d').get()-get_counter('g').get();
   }
+  /** Get a snapshot of the number of nodes, the method could be called by another thread.
+    * @return the number of nodes stored in the priority queue.
+    */
+  long PeekNbN() const {
+    return peek_counter('i') - peek_counter('d') - peek_counter('g');
+  }
 };
 
 /** The Priority Queue interface
@@ -94,10 +119,14 @@ protected:
    * priority queue at the same time.
    */
   int ref;
+  /** this data is set when a checkpoint of the priority queue is requested,
+   * the algorithms must then call ckpt_pause() at their next safepoint.
+   */
+  volatile int ckreq;
 public :
   /** Constructor (mainly do nothing)
     */
-  PQInterface() : ref(0) {}
+  PQInterface() : ref(0), ckreq(0) {}
   /** Destructor (mainly do nothing)
     */
   virtual ~PQInterface() {}
@@ -124,6 +153,25 @@ public :
     * @return the deleted node
     */
   virtual Node *Del() = 0;
+  /** Insert several nodes at once.
+    * The default implementation inserts the nodes one by one.
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  virtual void InsBatch(Node **nds,int nb) {
+    for (int i=0;i<nb;i++ ) Ins(nds[i]);
+  }
+  /** Delete at most nb of the best prioritized Nodes, in the order of the priority.
+    * The default implementation deletes the nodes one by one.
+    * @param nds the array that receives the deleted nodes
+    * @param nb the maximum number of nodes to delete
+    * @return the number of deleted nodes
+    */
+  virtual int DelBatch(Node **nds,int nb) {
+    int i;
+    for (i=0;i<nb && (nds[i]=Del())!=0;i++ );
+    return i;
+  }
   /** Removes all unneeded Nodes with regard to the Goal
     * @param n the goal to compare...
     */
@@ -136,6 +184,19 @@ public :
     * @return a pointer on the PQStat object.
     */
   //virtual PQStat *getStat() = 0;
+  /** Write the metrics of the priority queue as key=value fields.
+    * The method is called by the metrics sampler (see the -- -mf option) while the 
+    * search is running, then it must not lock the priority queue.
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) { }
+  /** Get the best key of the stored nodes in O(1), it is used as the bound of the search.
+    * When the key of the priority only depends on the evaluation (PriComp::isEvalKey()),
+    * the key of a node is its evaluation, negated for a maximization (see Eval::pri_key()).
+    * @return the smallest key PriComp::key() of the stored nodes, HUGE_VAL if the priority
+    *   queue is empty, -HUGE_VAL if the bound is unknown.
+    */
+  virtual double BestKey() { return -HUGE_VAL; }
   /** Method to return the number of nodes stored in th priority queue.
     * @return the number of nodes
     */
@@ -174,6 +235,55 @@ public :
       v=0;
       se.Pack(&v,1);
   }
+  /** Pack all the internal nodes without removing them.
+    * The format is the one of the Pack method.
+    * @param se the Serialize object
+    */
+  virtual void Snapshot(Serialize &se) {
+      int v=0;
+      SnapshotNodes(se);
+      se.Pack(&v,1);
+  }
+  /** Pack all the internal nodes without removing them and without the end mark.
+    * The default implementation deletes the nodes and inserts them again.
+    * @param se the Serialize object
+    */
+  virtual void SnapshotNodes(Serialize &se) {
+      std::vector<Node *> t;
+      Node *n;
+      int v=1;
+      while (( n=Del())!=0 ) {
+         se.Pack(&v,1);
+         n->Pack(se);
+         t.push_back(n);
+      }
+      if ( !t.empty() ) InsBatch(&t[0],t.size());
+  }
+  /** @name Checkpoint of the nodes
+    * A checkpoint is taken at an epoch where all the nodes of the search are
+    * stored in the priority queue. The algorithms test ckpt_requested() at each
+    * iteration, and call ckpt_pause() when it returns true.
+    * The default priority queue does not support the checkpoint.
+    */
+  //@{
+  /// test if a checkpoint is requested
+  bool ckpt_requested() const {
+    return ckreq!=0;
+  }
+  /** Method called by an algorithm, that does not store any node, when a checkpoint is requested.
+    * The method returns when the checkpoint is taken.
+    */
+  virtual void ckpt_pause() { }
+  /** Begin a checkpoint : waits until all the nodes are stored in the priority queue.
+    * @return true if the checkpoint can be taken, then the priority queue
+    *  could be packed with the Snapshot() method, and ckpt_end() must be called.
+    */
+  virtual bool ckpt_begin() {
+    return false;
+  }
+  /// End a checkpoint, the paused algorithms are resumed.
+  virtual void ckpt_end() { }
+  //@}
   /** UnPack and insert nodes
     * @param se the DeSerialize object
     */
@@ -233,10 +343,18 @@ public:
   void StIns(Node *n = 0) {
     pqs->Ins();
   }
+  /// Statistics for the insertion of nb nodes.
+  void StInsN(int nb) {
+    pqs->InsN(nb);
+  }
   /// Statistics for delete.
   void StDel(Node *n = 0) {
     pqs->Del();
   }
+  /// Statistics for the deletion of nb nodes.
+  void StDelN(int nb) {
+    pqs->DelN(nb);
+  }
   /// Statistics for deleteGreater.
   void StDelG(int nb = 1) {
     pqs->DelG(nb);
@@ -260,6 +378,12 @@ public:
     * @return the number of nodes
     */
   virtual long nb_node() {  return getStat()->GetNbN(); }
+  /** Write the number of nodes stored in the priority queue.
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) {
+    os << " open=" << getStat()->PeekNbN();
+  }
 
   /** Method to test if node are required in th priority queue.
     * @return true if the priority queue is empty
@@ -340,6 +464,12 @@ private:
 
     p->Left() = q2;
   }
+  /// compare the roots of two subtrees for the heap of DelBatch()
+  struct Worse {
+    bool operator()(const Node *a, const Node *b) const {
+      return PriComp::isBetter(*b, *a);
+    }
+  };
   /// the swap method
   void Swap(Node **q1, Node **q2) {
     Node *dum;
@@ -389,6 +519,22 @@ public:
     PQ<Node, PriComp, Goal>::StIns();
     Meld(n, r);
   }
+  /** Insert several nodes at once.
+    * The nodes are melded in a separate skew heap, 
+    * which is then melded with the skew heap of the priority queue.
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  void InsBatch(Node **nds,int nb) {
+    Node *rs = r;
+    r = 0;
+    for (int i=0;i<nb;i++ ) {
+      nds[i]->addRef();
+      Meld(nds[i], r);
+    }
+    Meld(r, rs);
+    PQ<Node, PriComp, Goal>::StInsN(nb);
+  }
   /// Delete the Node with the highest priority
   Node *Del() {
     Node *p;
@@ -400,10 +546,43 @@ public:
     p->remRef();
     return p;
   }
+  /** Delete at most nb of the best Nodes.
+    * The subtrees of the deleted nodes are kept as candidates in a heap of
+    * their roots, the best root is the next deleted node. The remaining 
+    * subtrees are melded once at the end.
+    * @param nds the array that receives the deleted nodes
+    * @param nb the maximum number of nodes to delete
+    * @return the number of deleted nodes
+    */
+  int DelBatch(Node **nds,int nb) {
+    std::vector<Node *> c;
+    int i;
+    if ( r==0 || nb<=0 ) return 0;
+    c.push_back(r);
+    r = 0;
+    for (i=0;i<nb && !c.empty();i++ ) {
+      std::pop_heap(c.begin(),c.end(),Worse());
+      Node *p = c.back();
+      c.pop_back();
+      if ( p->Left()!=0 ) { c.push_back((Node*)p->Left()); std::push_heap(c.begin(),c.end(),Worse()); }
+      if ( p->Right()!=0 ) { c.push_back((Node*)p->Right()); std::push_heap(c.begin(),c.end(),Worse()); }
+      p->Left() = p->Right() = 0;
+      p->remRef();
+      nds[i] = p;
+    }
+    for (unsigned int j=0;j<c.size();j++ ) Meld(c[j], r);
+    PQ<Node, PriComp,Goal>::StDelN(i);
+    return i;
+  }
   /// Delete the Nodes with a lower priority than p
   virtual int DelG(Goal &g) {
     return 0;
   }
+  /// get the key of the root
+  virtual double BestKey() {
+    if (!PriComp::isEvalKey()) return -HUGE_VAL;
+    return (r == 0 ? HUGE_VAL : PriComp::key(*r));
+  }
   /// Displays statistics and Contents
   ostream &Prt(ostream &o = std::cout) const {
     o << "Bob::PQSkew: no display" << std::endl;
@@ -627,6 +806,26 @@ public:
     h.push_back(n);
     down(h.size() - 1);
   }
+  /** Insert several nodes at once.
+    * If the number of inserted nodes is greater than the number of stored nodes
+    * the heap is rebuilt bottom-up, otherwise each node is moved to its place.
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  virtual void InsBatch(Node **nds,int nb) {
+    int i,first = h.size();
+    if ( nb<=0 ) return;
+    h.reserve(first+nb);
+    for (i=0;i<nb;i++ ) {
+      nds[i]->addRef();
+      h.push_back(nds[i]);
+    }
+    if ( nb > first ) {
+      for (i=((int)h.size()-2)/level;i>=0;i-- ) up(i);
+    } else {
+      for (i=first;i<(int)h.size();i++ ) down(i);
+    }
+  }
   /// Delete the Node at an arbitrary position in the heap
   virtual Node *Del(int pos) {
     if (h.size() == 0)
@@ -645,6 +844,45 @@ public:
   Node *Del() {
     return Del(0);
   }
+  /** Delete at most nb of the best Nodes.
+    * The positions of the nb best nodes are selected with a heap of candidate 
+    * positions (the children of the selected positions), without moving the nodes.
+    * The selected positions form the top of the heap : they are filled with 
+    * the last nodes, and the heap is rebuilt bottom-up from these positions only.
+    * @param nds the array that receives the deleted nodes
+    * @param nb the maximum number of nodes to delete
+    * @return the number of deleted nodes
+    */
+  virtual int DelBatch(Node **nds,int nb) {
+    int sz = h.size(), i, j;
+    if ( nb > sz ) nb = sz;
+    if ( nb <= 0 ) return 0;
+    std::vector<int> c(1,0), sel;
+    PosWorse w(h);
+    sel.reserve(nb);
+    for (i=0;i<nb;i++ ) {
+      std::pop_heap(c.begin(),c.end(),w);
+      int p = c.back();
+      c.pop_back();
+      sel.push_back(p);
+      nds[i] = h[p];
+      for (j=p*level+1;j<=p*level+level && j<sz;j++ ) {
+        c.push_back(j);
+        std::push_heap(c.begin(),c.end(),w);
+      }
+    }
+    // the nodes stored after the new end and not deleted fill the selected positions
+    std::sort(sel.begin(),sel.end());
+    int nsz = sz-nb, last = sz-1, k = nb-1;
+    for (i=0;i<nb && sel[i]<nsz;i++ ) {
+      while ( k>=0 && sel[k]==last ) { k--; last--; }
+      h[sel[i]] = h[last--];
+    }
+    h.resize(nsz);
+    for (j=i-1;j>=0;j-- ) up(sel[j]);
+    for (i=0;i<nb;i++ ) nds[i]->remRef();
+    return nb;
+  }
   /// Removes all unneeded Nodes with regard to the Goal
   virtual int DelG(Goal &g) {
     /* Span all Nodes from the end to the beginning of the vector */
@@ -673,6 +911,20 @@ public:
     }
     return count;
   }
+  /// get the root of the heap (0 if the heap is empty)
+  Node *Top() {
+    return (h.empty() ? 0 : h[0]);
+  }
+protected:
+  /// compare the nodes at two positions for the heap of candidates of DelBatch()
+  struct PosWorse {
+    const std::vector<Node*> &h;
+    PosWorse(const std::vector<Node*> &_h) : h(_h) {}
+    bool operator()(int a, int b) const {
+      return PriComp::isBetter(*h[b], *h[a]);
+    }
+  };
+public:
   /// Displays statistics and Contents
   virtual ostream &Prt(ostream &o = std::cout) const {
     o << "Bob::PQHnBase: no display" << std::endl;
@@ -763,6 +1015,11 @@ public:
     base::Ins(n);
     PQ<Node, PriComp,Goal>::StIns();
   }
+  /// Insert several nodes at once
+  virtual void InsBatch(Node **nds,int nb) {
+    base::InsBatch(nds,nb);
+    PQ<Node, PriComp,Goal>::StInsN(nb);
+  }
   /// Delete the Node at an arbitrary position in the heap
   virtual Node *Del(int pos) {
     Node *b = base::Del(pos);
@@ -770,18 +1027,269 @@ public:
       PQ<Node, PriComp,Goal>::StDel();
     return b;
   }
+  /// Delete at most nb of the best Nodes
+  virtual int DelBatch(Node **nds,int nb) {
+    int nbd = base::DelBatch(nds,nb);
+    PQ<Node, PriComp,Goal>::StDelN(nbd);
+    return nbd;
+  }
   /// Removes all unneeded Nodes with regard to the Goal
   virtual int DelG(Goal &g) {
     int count = base::DelG(g);
     PQ<Node, PriComp,Goal>::StDelG(count);
     return count;
   }  
+  /// get the key of the root of the heap
+  virtual double BestKey() {
+    if (!PriComp::isEvalKey()) return -HUGE_VAL;
+    Node *t = base::Top();
+    return (t == 0 ? HUGE_VAL : PriComp::key(*t));
+  }
   /// Reset the priority queue
   virtual void Reset() {
   }
 
 };
 
+/**
+  * Priority Queue implementation: a n-Heap with inline keys.
+  *
+  * The priority key of a node (PriComp::key()) is computed once at the insertion,
+  * and the keys are stored in a contiguous array beside the array of node pointers.
+  * Then the sift operations compare the keys without accessing the nodes, 
+  * the nodes are only compared (with PriComp::isBetter()) when their keys are equal.
+  * The default arity (8) puts all the keys of the children of a node in one cache line,
+  * the best child is searched using SSE2 instructions if they are available.
+  */
+template <class Node, class PriComp, class Goal, int level = 8>
+class PQHk : public PQ<Node, PriComp, Goal> {
+protected:
+  /// the keys of the nodes
+  std::vector<double> hk;
+  /// the nodes
+  std::vector<Node*> hn;
+
+  /// test if the entry (k1,n1) is better than the entry (k2,n2)
+  static bool better(double k1, Node *n1, double k2, Node *n2) {
+    return k1 < k2 || (k1 == k2 && PriComp::isBetter(*n1, *n2));
+  }
+  /** get the minimum of an array of keys
+    * @param k the array of keys
+    * @param nb the size of the array (must be >0)
+    */
+  static double kmin(const double *k, int nb) {
+    int i = 0;
+    double m = k[0];
+#ifdef __SSE2__
+    if (nb >= 2) {
+      double t[2];
+      __m128d v = _mm_loadu_pd(k);
+      for (i = 2; i + 1 < nb; i += 2)
+        v = _mm_min_pd(v, _mm_loadu_pd(k + i));
+      _mm_storeu_pd(t, v);
+      m = (t[0] < t[1] ? t[0] : t[1]);
+    }
+#endif
+    for (; i < nb; i++)
+      if (k[i] < m) m = k[i];
+    return m;
+  }
+  /** get the index of the best child of a node
+    * @param first the index of the first child
+    * @param last the index after the last child
+    */
+  int best_child(int first, int last) {
+    double m = kmin(&hk[first], last - first);
+    int i, best = -1;
+    for (i = first; i < last; i++) {
+      if (hk[i] == m && (best == -1 || PriComp::isBetter(*hn[i], *hn[best])))
+        best = i;
+    }
+    return best;
+  }
+  /** Spans a path from a specified entry to the root.
+   * @param n index of the entry
+   */
+  void down(int n) {
+    int p;
+    double k = hk[n];
+    Node *m = hn[n];
+    while (n > 0) {
+      p = (n-1) / level;
+      if (!better(k, m, hk[p], hn[p])) break;
+      hk[n] = hk[p];
+      hn[n] = hn[p];
+      n = p;
+    }
+    hk[n] = k;
+    hn[n] = m;
+  }
+  /** Spans a path from a specified entry to a leaf.
+   * @param n index of the entry
+   */
+  void up(int n) {
+    int max = hk.size();
+    int first, last, best;
+    double k = hk[n];
+    Node *m = hn[n];
+    while ((first = n * level + 1) < max) {
+      last = (first + level < max ? first + level : max);
+      best = best_child(first, last);
+      if (!better(hk[best], hn[best], k, m)) break;
+      hk[n] = hk[best];
+      hn[n] = hn[best];
+      n = best;
+    }
+    hk[n] = k;
+    hn[n] = m;
+  }
+  /** Remove the entry at position pos
+   * @param pos the position of the entry
+   * @return the node of the entry
+   */
+  Node *remove(int pos) {
+    int last = hk.size() - 1;
+    Node *b = hn[pos];
+    hk[pos] = hk[last];
+    hn[pos] = hn[last];
+    hk.pop_back();
+    hn.pop_back();
+    if (pos < last) {
+      if (pos > 0 && better(hk[pos], hn[pos], hk[(pos-1)/level], hn[(pos-1)/level]))
+        down(pos);
+      else
+        up(pos);
+    }
+    return b;
+  }
+
+public:
+  /** Default Constructor
+    */
+  PQHk() : PQ<Node, PriComp,Goal>(), hk(), hn() { }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQHk(const Id &id,bool g = true) : PQ<Node, PriComp,Goal>(id,g), hk(), hn() { }
+  /** Constructor
+    * @param st the priority queue statistics
+    */
+  PQHk(stat *st) : PQ<Node, PriComp,Goal>(st), hk(), hn() { }
+  /// Destructor
+  virtual ~PQHk() {
+    Reset();
+  }
+  /// Reset the priority queue and its statistics
+  virtual void Reset() {
+    Node *f;
+    while ((f = Del()) != 0) {
+      if (f->isDel()) delete f;
+    }
+    PQ<Node, PriComp, Goal>::Reset();
+  }
+  /// Insert a Node n
+  virtual void Ins(Node *n) {
+    n->addRef();
+    hk.push_back(PriComp::key(*n));
+    hn.push_back(n);
+    down(hk.size() - 1);
+    PQ<Node, PriComp,Goal>::StIns();
+  }
+  /** Insert several nodes at once.
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  virtual void InsBatch(Node **nds,int nb) {
+    int i,first = hk.size();
+    if ( nb<=0 ) return;
+    hk.reserve(first+nb);
+    hn.reserve(first+nb);
+    for (i=0;i<nb;i++ ) {
+      nds[i]->addRef();
+      hk.push_back(PriComp::key(*nds[i]));
+      hn.push_back(nds[i]);
+    }
+    if ( nb > first ) {
+      for (i=((int)hk.size()-2)/level;i>=0;i-- ) up(i);
+    } else {
+      for (i=first;i<(int)hk.size();i++ ) down(i);
+    }
+    PQ<Node, PriComp,Goal>::StInsN(nb);
+  }
+  /// Delete the Node with the highest priority
+  virtual Node *Del() {
+    if (hk.size() == 0) return 0;
+    Node *b = remove(0);
+    b->remRef();
+    PQ<Node, PriComp,Goal>::StDel();
+    return b;
+  }
+  /// Delete the Node with the highest priority (no other priority for load balancing)
+  virtual Node *DelLB() {
+    return Del();
+  }
+  /// Removes all unneeded Nodes with regard to the Goal
+  virtual int DelG(Goal &g) {
+    int i, count = 0;
+    Node *nd;
+    for (i = hk.size() - 1; i >= 0; i--) {
+      if (i < (int)hk.size() && !g.is4Search((nd = hn[i]))) {
+        remove(i);
+        if (nd->remRef() == 0) {
+          delete nd;
+        }
+        count++;
+        i++;
+      }
+    }
+    PQ<Node, PriComp,Goal>::StDelG(count);
+    return count;
+  }
+  /// get the key of the root of the heap
+  virtual double BestKey() {
+    if (!PriComp::isEvalKey()) return -HUGE_VAL;
+    return (hk.empty() ? HUGE_VAL : hk[0]);
+  }
+  /// get the key of the root of the heap, whatever the priority is (HUGE_VAL if the heap is empty)
+  double TopKey() const {
+    return (hk.empty() ? HUGE_VAL : hk[0]);
+  }
+  /// get the number of nodes of the heap
+  long size() const {
+    return hk.size();
+  }
+  /// Displays statistics and Contents
+  virtual ostream &Prt(ostream &o = std::cout) const {
+    o << "Bob::PQHk: no display" << std::endl;
+    return o;
+  }
+};
+
+/**
+  * The PQHk with the template parameters of the PQLB class, then it 
+  * could be used as the internal priority queue of the threaded environment.
+  * The load balancing priority is not used.
+  */
+template<class Node, class PriComp, class PriLB, class Goal>
+class PQHkLB : public PQHk<Node, PriComp, Goal> {
+public:
+  /** Default Constructor
+    */
+  PQHkLB() : PQHk<Node, PriComp, Goal>() { }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQHkLB(const Id &id, bool g=true) : PQHk<Node, PriComp, Goal>(id,g) { }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQHkLB(stat *st) : PQHk<Node, PriComp, Goal>(st) { }
+  /// Destructor
+  virtual ~PQHkLB() { }
+};
+
 /** @}
   */
 
@@ -872,6 +1380,17 @@ public:
 
   /// destructor
   virtual ~PQLBi() { }
+  /** Insert several nodes at once.
+    * The index of the nodes which are not moved by the bottom-up 
+    * construction of the heap are updated.
+    */
+  virtual void InsBatch(Node **nds,int nb) {
+    int first = base::h.size();
+    base::InsBatch(nds,nb);
+    if ( nb > first ) {
+      for (unsigned int i=0;i<base::h.size();i++ ) base::h[i]->idx(rank) = i;
+    }
+  }
 };
 
 /**
@@ -922,6 +1441,15 @@ public:
     pqlb.Ins(b);
     PQ<Node, PriComp,Goal>::StIns();
   }
+  /** insert several nodes at once
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  virtual void InsBatch(Node **nds,int nb) {
+    pq.InsBatch(nds,nb);
+    pqlb.InsBatch(nds,nb);
+    PQ<Node, PriComp,Goal>::StInsN(nb);
+  }
   /// Delete node with highest search priority
   virtual Node *Del() {
     Node *b = pq.Del();
@@ -931,6 +1459,19 @@ public:
     }
     return b;
   }
+  /** Delete at most nb nodes with the highest search priority.
+    * The nodes are deleted at once from the heap of the search priority,
+    * then each one is deleted at its position in the heap of the load balancing.
+    * @param nds the array that receives the deleted nodes
+    * @param nb the maximum number of nodes to delete
+    * @return the number of deleted nodes
+    */
+  virtual int DelBatch(Node **nds,int nb) {
+    int nbd = pq.DelBatch(nds,nb);
+    for (int i=0;i<nbd;i++ ) pqlb.Del(nds[i]->idx(1));
+    PQ<Node, PriComp,Goal>::StDelN(nbd);
+    return nbd;
+  }
   /// Delete node with highest load balancing priority
   virtual Node *DelLB() {
     Node *b = pqlb.Del();
@@ -948,6 +1489,12 @@ public:
     PQ<Node, PriComp,Goal>::StDelG(count);
     return count;
   }
+  /// get the best key of the stored nodes, from the heap of the search priority
+  virtual double BestKey() {
+    if (!PriComp::isEvalKey()) return -HUGE_VAL;
+    Node *t = pq.Top();
+    return (t == 0 ? HUGE_VAL : PriComp::key(*t));
+  }
 
   /// Displays statistics and Contents
   virtual ostream &Prt(ostream &o = std::cout) const {
@@ -961,6 +1508,589 @@ public:
 
 /** @}
   */
+/** @defgroup BucketPQGRP Bucket implementation of a priority Queue.
+ *  @name  Another implementation of Priority queue for integer or quantized keys.
+ *
+ *  The nodes are stored in buckets according to their quantized key (see PQHk).
+ * @{
+ */
+
+/**
+  * Priority Queue implementation: the bucket priority queue.
+  *
+  * The key of a node (PriComp::key()) is divided by the quantum given by the -- -bq option,
+  * and the floor of the result is the number of the bucket of the node.
+  * The insertion and the deletion are in O(1) when the inserted keys are
+  * greater than the key of the best node (monotone priority queue), the nodes of a 
+  * bucket are deleted in the LIFO order.
+  * When the keys only depend on the evaluation (PriComp::isEvalKey()), the DelG method
+  * tests only one node per bucket to drop it, and stops at the first kept bucket.
+  * The buckets span at most MAX_BK quanta: the nodes whose key is outside this range,
+  * infinite or NaN are stored in an overflow heap (PQHk) and compared with the first
+  * bucket at each deletion.
+  */
+template<class Node, class PriComp, class Goal>
+class PQBucket : public PQ<Node, PriComp, Goal> {
+protected:
+  /// A bucket
+  struct Bucket {
+    /// the nodes of the bucket
+    std::vector<Node *> n;
+    /// the key of the first node inserted in the bucket
+    double k;
+    /// true if the bucket stores nodes with different keys
+    bool mixed;
+    /// Constructor
+    Bucket() : n(), k(0), mixed(false) {}
+  };
+  /// the maximum number of buckets
+  enum { MAX_BK = 65536 };
+  /// the buckets
+  std::deque<Bucket> bk;
+  /// the number of the first bucket
+  long base;
+  /// the quantum of the keys
+  double q;
+  /// the overflow heap that stores the nodes whose key is outside the range of the buckets
+  PQHk<Node, PriComp, Goal> ovf;
+
+  /// removes the empty buckets at the beginning of the deque
+  void trim() {
+    while (!bk.empty() && bk.front().n.empty()) {
+      bk.pop_front();
+      base++;
+    }
+    while (!bk.empty() && bk.back().n.empty()) {
+      bk.pop_back();
+    }
+  }
+  /** drop a node
+    * @param nd the node to drop
+    */
+  void drop(Node *nd) {
+    if (nd->remRef() == 0) {
+      delete nd;
+    }
+  }
+  /** get the number of the bucket of a key
+    * @param k the key
+    * @param b the number of the bucket
+    * @return false if the key must be stored in the overflow heap
+    */
+  bool bucket(double k, long &b) const {
+    double f = floor(k / q);
+    // also false for an infinite or NaN key
+    if (!(fabs(f) < 1e15)) return false;
+    b = (long)f;
+    if (bk.empty()) return true;
+    long lo = (b < base ? b : base), hi = base + (long)bk.size() - 1;
+    if (b > hi) hi = b;
+    return hi - lo < MAX_BK;
+  }
+
+public:
+  /** Default Constructor
+    */
+  PQBucket() : PQ<Node, PriComp, Goal>(), bk(), base(0), q(core::get_bucket_q()), ovf() { }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQBucket(const Id &id, bool g=true) : PQ<Node, PriComp, Goal>(id,g), bk(), base(0), q(core::get_bucket_q()), ovf() { }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQBucket(stat *st) : PQ<Node, PriComp, Goal>(st), bk(), base(0), q(core::get_bucket_q()), ovf() { }
+  /// Destructor
+  virtual ~PQBucket() {
+    Reset();
+  }
+  /// Reset the priority queue
+  virtual void Reset() {
+    Node *f;
+    while ((f = Del()) != 0) {
+      if (f->isDel()) delete f;
+    }
+  }
+  /** insert a node
+    * @param nd the node to insert
+    */
+  virtual void Ins(Node *nd) {
+    double k = PriComp::key(*nd);
+    long b;
+    if (!bucket(k, b)) {
+      ovf.Ins(nd);
+      PQ<Node, PriComp, Goal>::StIns();
+      return;
+    }
+    if (bk.empty()) base = b;
+    if (b < base) {
+      bk.insert(bk.begin(), base - b, Bucket());
+      base = b;
+    }
+    if (b - base >= (long)bk.size()) bk.resize(b - base + 1);
+    Bucket &bu = bk[b - base];
+    if (bu.n.empty()) {
+      bu.k = k;
+      bu.mixed = false;
+    } else if (bu.k != k) bu.mixed = true;
+    nd->addRef();
+    bu.n.push_back(nd);
+    PQ<Node, PriComp, Goal>::StIns();
+  }
+  /// Delete the node of the best bucket, or the best node of the overflow heap if it is better
+  virtual Node *Del() {
+    Node *nd;
+    trim();
+    if (ovf.size() > 0 && (bk.empty() || ovf.TopKey() < base * q)) {
+      nd = ovf.Del();
+      PQ<Node, PriComp, Goal>::StDel();
+      return nd;
+    }
+    if (bk.empty()) return 0;
+    nd = bk.front().n.back();
+    bk.front().n.pop_back();
+    nd->remRef();
+    PQ<Node, PriComp, Goal>::StDel();
+    return nd;
+  }
+  /// Delete the node of the best bucket (no other priority for load balancing)
+  virtual Node *DelLB() {
+    return Del();
+  }
+  /// Removes all unneeded Nodes with regard to the Goal
+  virtual int DelG(Goal &g) {
+    int count = 0;
+    unsigned int j;
+    for (int i = bk.size() - 1; i >= 0; i--) {
+      Bucket &bu = bk[i];
+      if (bu.n.empty()) continue;
+      if (!bu.mixed && PriComp::isEvalKey()) {
+        if (g.is4Search(bu.n.back())) break;
+        for (j = 0; j < bu.n.size(); j++) drop(bu.n[j]);
+        count += bu.n.size();
+        bu.n.clear();
+      } else {
+        for (j = 0; j < bu.n.size(); ) {
+          if (!g.is4Search(bu.n[j])) {
+            drop(bu.n[j]);
+            bu.n[j] = bu.n.back();
+            bu.n.pop_back();
+            count++;
+          } else j++;
+        }
+      }
+    }
+    trim();
+    count += ovf.DelG(g);
+    PQ<Node, PriComp, Goal>::StDelG(count);
+    return count;
+  }
+  /** get the best key of the stored nodes : the key of the first non empty bucket
+    * or its lower limit if the bucket stores different keys.
+    */
+  virtual double BestKey() {
+    if (!PriComp::isEvalKey()) return -HUGE_VAL;
+    double o = ovf.TopKey();
+    for (unsigned int i = 0; i < bk.size(); i++) {
+      if (bk[i].n.empty()) continue;
+      double b = (bk[i].mixed ? (base + (long)i) * q : bk[i].k);
+      return (o < b ? o : b);
+    }
+    return o;
+  }
+  /// Displays statistics and Contents
+  virtual ostream &Prt(ostream &o = std::cout) const {
+    o << "Bob::PQBucket: " << bk.size() << " buckets from " << base 
+      << ", " << ovf.size() << " nodes in the overflow heap" << std::endl;
+    return o;
+  }
+};
+
+/**
+  * The PQBucket with the template parameters of the PQLB class, then it 
+  * could be used as the internal priority queue of the threaded environment.
+  * The load balancing priority is not used.
+  */
+template<class Node, class PriComp, class PriLB, class Goal>
+class PQBucketLB : public PQBucket<Node, PriComp, Goal> {
+public:
+  /** Default Constructor
+    */
+  PQBucketLB() : PQBucket<Node, PriComp, Goal>() { }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQBucketLB(const Id &id, bool g=true) : PQBucket<Node, PriComp, Goal>(id,g) { }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQBucketLB(stat *st) : PQBucket<Node, PriComp, Goal>(st) { }
+  /// Destructor
+  virtual ~PQBucketLB() { }
+};
+
+/** @}
+  */
+
+/** @defgroup SpillPQGRP External memory implementation of a priority Queue.
+ *  @name  Priority queue that keeps a bounded number of nodes in memory.
+ *
+ *  The best nodes are stored in memory in a PQHk, when their number exceeds the 
+ *  cap given by the -- -spm option, the worst half of them is written 
+ *  in a sorted run in a file of the directory given by the -- -spd option.
+ *  The runs are merged back on demand : each run keeps only its best node in memory,
+ *  the runs are kept in a heap ordered by their best node.
+ *  A spilled run is a file mapped in memory and unlinked at once, it holds no file
+ *  descriptor but one memory mapping : the number of runs (the number of spilled 
+ *  nodes divided by the half of the -- -spm cap) must stay under the system limit
+ *  of the mappings (vm.max_map_count).
+ *
+ *  The PQCompact uses the same runs but keeps them in memory : when the number of 
+ *  nodes exceeds the cap given by the -- -cpm option, the worst half of them is packed 
+ *  in a memory buffer. 
+ *  The nodes of the runs are stored with the base_Node::PackQ method, a node could 
+ *  redefine it to use a smaller form than the one of the Pack method.
+ * @{
+ */
+
+/**
+  * Priority Queue implementation: the spill priority queue.
+  *
+  * The nodes must implement the PackQ and UnPackQ methods (by default the Pack and UnPack methods).
+  * The PQStat counters 's' and 'r' count the spilled and the reloaded nodes.
+  * When the keys only depend on the evaluation (PriComp::isEvalKey()), the DelG method
+  * drops a run as soon as its best node is not suitable for the search,
+  * otherwise the nodes of the runs are pruned when they are reloaded.
+  */
+template<class Node, class PriComp, class Goal>
+class PQSpill : public PQHk<Node, PriComp, Goal> {
+  typedef PQHk<Node, PriComp, Goal> base;
+protected:
+  /// A sorted run stored in a file or in a memory buffer
+  struct Run {
+    /// the deserializer of the file or of the buffer
+    DeSerialMap *ds;
+    /// the memory buffer (0 if the run is stored in a file)
+    char *mem;
+    /// the best node of the run (loaded in memory)
+    Node *hd;
+    /// the key of the best node
+    double k;
+    /// the number of nodes of the run (including hd)
+    long nb;
+  };
+  /// the runs, a heap where the first run has the best node
+  std::vector<Run> runs;
+  /// the maximum number of nodes in memory
+  long cap;
+
+  /** add the statistics counters
+    * @param ls the label of the counter of the stored nodes
+    * @param lr the label of the counter of the reloaded nodes
+    */
+  void init_stat(const char *ls = "Spilled Nodes", const char *lr = "Reloaded Nodes") {
+    PQ<Node, PriComp, Goal>::getStat()->add_counter('s',ls,true);
+    PQ<Node, PriComp, Goal>::getStat()->add_counter('r',lr,true);
+  }
+  /** load the best node of a run
+    * @param ru the run
+    */
+  void load(Run &ru) {
+    ru.hd = new Node();
+    ru.hd->UnPackQ(*ru.ds);
+    ru.hd->addRef();
+    ru.k = PriComp::key(*ru.hd);
+    PQ<Node, PriComp, Goal>::getStat()->get_counter('r')++;
+  }
+  /** release the storage of a run
+    * @param ru the run
+    */
+  void release(Run &ru) {
+    delete ru.ds;
+    if (ru.mem != 0) free(ru.mem);
+  }
+  /** store the packed nodes of a new run in a file.
+    * @param sb the buffer that stores the packed nodes
+    * @param ru the run
+    */
+  virtual void store(const SerialBuf &sb, Run &ru) {
+    // the name is unique among the processes and the priority queues
+    std::string fn = core::get_spill_dir() + "/bobpp_spill_XXXXXX";
+    std::vector<char> t(fn.begin(), fn.end());
+    t.push_back(0);
+    int fd = mkstemp(&t[0]);
+    if (fd < 0) BOBEXCEPTION(IOException, "PQSpill", "could not create the spill file");
+    close(fd);
+    fn = &t[0];
+    if (!sb.write(fn)) {
+      unlink(fn.c_str());
+      BOBEXCEPTION(IOException, "PQSpill", "could not write the spill file");
+    }
+    ru.mem = 0;
+    ru.ds = new DeSerialMap(fn);
+    unlink(fn.c_str());
+    if (!ru.ds->is_open()) BOBEXCEPTION(IOException, "PQSpill", "could not map the spill file");
+  }
+  /// the order of the heap of runs : the worst run is lower
+  struct RunComp {
+    bool operator()(const Run &a, const Run &b) const {
+      return base::better(b.k, b.hd, a.k, a.hd);
+    }
+  };
+  /// load the next node of the best run, the run is removed if it is empty.
+  void next() {
+    std::pop_heap(runs.begin(), runs.end(), RunComp());
+    Run &ru = runs.back();
+    if ( --ru.nb == 0 ) {
+      release(ru);
+      runs.pop_back();
+      return;
+    }
+    load(ru);
+    std::push_heap(runs.begin(), runs.end(), RunComp());
+  }
+  /** drop a run, the order of the heap must be restored by the caller.
+    * @param r the index of the run
+    */
+  void drop(int r) {
+    if ( runs[r].hd->remRef() == 0 ) delete runs[r].hd;
+    release(runs[r]);
+    runs[r] = runs.back();
+    runs.pop_back();
+  }
+  /** pack the worst half of the nodes in memory in a new run.
+    * The nodes are removed from the heap in the priority order, the best 
+    * ones are kept in a sorted array, which is a valid heap.
+    */
+  void spill() {
+    int nb = base::hk.size(), nk = cap / 2, i;
+    std::vector<double> kk;
+    std::vector<Node *> kn;
+    SerialBuf sb;
+    Run ru;
+    Node *n;
+    kk.reserve(nk);
+    kn.reserve(nk);
+    for (i = 0; i < nk; i++) {
+      kk.push_back(base::hk[0]);
+      kn.push_back(base::remove(0));
+    }
+    ru.nb = nb - nk;
+    for (i = 0; i < ru.nb; i++) {
+      n = base::remove(0);
+      n->PackQ(sb);
+      if (n->remRef() == 0) delete n;
+    }
+    base::hk.swap(kk);
+    base::hn.swap(kn);
+    store(sb, ru);
+    load(ru);
+    runs.push_back(ru);
+    std::push_heap(runs.begin(), runs.end(), RunComp());
+    PQ<Node, PriComp, Goal>::getStat()->get_counter('s') += ru.nb;
+  }
+  /** Constructor used by the derived classes
+    * @param c the maximum number of nodes in memory
+    */
+  PQSpill(long c) : base(), runs(), cap(c) { }
+  /** Constructor used by the derived classes
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    * @param c the maximum number of nodes in memory
+    */
+  PQSpill(const Id &id, bool g, long c) : base(id,g), runs(), cap(c) { }
+  /** Constructor used by the derived classes
+    * @param st the Priority Queue statistics
+    * @param c the maximum number of nodes in memory
+    */
+  PQSpill(stat *st, long c) : base(st), runs(), cap(c) { }
+
+public:
+  /** Default Constructor
+    */
+  PQSpill() : base(), runs(), cap(core::get_spill_max()) { init_stat(); }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQSpill(const Id &id, bool g=true) : base(id,g), runs(), cap(core::get_spill_max()) { init_stat(); }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQSpill(stat *st) : base(st), runs(), cap(core::get_spill_max()) { init_stat(); }
+  /// Destructor
+  virtual ~PQSpill() {
+    Reset();
+  }
+  /// Reset the priority queue
+  virtual void Reset() {
+    while (!runs.empty()) drop(runs.size() - 1);
+    base::Reset();
+  }
+  /** insert a node
+    * @param n the node to insert
+    */
+  virtual void Ins(Node *n) {
+    base::Ins(n);
+    if ((long)base::hk.size() > cap) spill();
+  }
+  /** insert several nodes at once
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  virtual void InsBatch(Node **nds, int nb) {
+    base::InsBatch(nds, nb);
+    if ((long)base::hk.size() > cap) spill();
+  }
+  /// Delete the best node among the nodes in memory and the best nodes of the runs
+  virtual Node *Del() {
+    if (runs.empty() || (base::hk.size() > 0 && 
+          base::better(base::hk[0], base::hn[0], runs[0].k, runs[0].hd))) {
+      return base::Del();
+    }
+    Node *b = runs[0].hd;
+    next();
+    b->remRef();
+    PQ<Node, PriComp, Goal>::StDel();
+    return b;
+  }
+  /// Delete the best node (no other priority for load balancing)
+  virtual Node *DelLB() {
+    return Del();
+  }
+  /// Removes all unneeded Nodes with regard to the Goal
+  virtual int DelG(Goal &g) {
+    int count = base::DelG(g);
+    if (PriComp::isEvalKey()) {
+      int nbr = 0;
+      for (int r = runs.size() - 1; r >= 0; r--) {
+        if (!g.is4Search(runs[r].hd)) {
+          nbr += runs[r].nb;
+          drop(r);
+        }
+      }
+      std::make_heap(runs.begin(), runs.end(), RunComp());
+      PQ<Node, PriComp, Goal>::StDelG(nbr);
+      count += nbr;
+    }
+    return count;
+  }
+  /// get the best key among the nodes in memory and the best nodes of the runs
+  virtual double BestKey() {
+    double k = base::BestKey();
+    if (!runs.empty() && runs[0].k < k) k = runs[0].k;
+    return k;
+  }
+  /// Displays statistics and Contents
+  virtual ostream &Prt(ostream &o = std::cout) const {
+    o << "Bob::PQSpill: no display" << std::endl;
+    return o;
+  }
+};
+
+/**
+  * The PQSpill with the template parameters of the PQLB class, then it 
+  * could be used as the internal priority queue of the threaded environment.
+  * The load balancing priority is not used.
+  */
+template<class Node, class PriComp, class PriLB, class Goal>
+class PQSpillLB : public PQSpill<Node, PriComp, Goal> {
+public:
+  /** Default Constructor
+    */
+  PQSpillLB() : PQSpill<Node, PriComp, Goal>() { }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQSpillLB(const Id &id, bool g=true) : PQSpill<Node, PriComp, Goal>(id,g) { }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQSpillLB(stat *st) : PQSpill<Node, PriComp, Goal>(st) { }
+  /// Destructor
+  virtual ~PQSpillLB() { }
+};
+
+/**
+  * Priority Queue implementation: the compact priority queue.
+  *
+  * The PQCompact is a PQSpill where the runs are stored in memory buffers.
+  * The nodes that are not among the best ones are stored in their packed form 
+  * (see base_Node::PackQ), which reduces the memory used by the large open lists.
+  * The PQStat counters 's' and 'r' count the packed and the unpacked nodes.
+  */
+template<class Node, class PriComp, class Goal>
+class PQCompact : public PQSpill<Node, PriComp, Goal> {
+  typedef PQSpill<Node, PriComp, Goal> base;
+protected:
+  /** store the packed nodes of a new run in a memory buffer.
+    * @param sb the buffer that stores the packed nodes
+    * @param ru the run
+    */
+  virtual void store(const SerialBuf &sb, typename base::Run &ru) {
+    ru.mem = (char *)malloc(sb.size());
+    if (ru.mem == 0) BOBEXCEPTION(NullPointerException, "PQCompact", "could not allocate a run");
+    memcpy(ru.mem, sb.data(), sb.size());
+    ru.ds = new DeSerialMap(ru.mem, sb.size());
+  }
+public:
+  /** Default Constructor
+    */
+  PQCompact() : base(core::get_compact_max()) { 
+    base::init_stat("Packed Nodes", "Unpacked Nodes"); 
+  }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQCompact(const Id &id, bool g=true) : base(id, g, core::get_compact_max()) { 
+    base::init_stat("Packed Nodes", "Unpacked Nodes"); 
+  }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQCompact(stat *st) : base(st, core::get_compact_max()) { 
+    base::init_stat("Packed Nodes", "Unpacked Nodes"); 
+  }
+  /// Destructor
+  virtual ~PQCompact() { }
+  /// Displays statistics and Contents
+  virtual ostream &Prt(ostream &o = std::cout) const {
+    o << "Bob::PQCompact: no display" << std::endl;
+    return o;
+  }
+};
+
+/**
+  * The PQCompact with the template parameters of the PQLB class, then it 
+  * could be used as the internal priority queue of the threaded environment.
+  * The load balancing priority is not used.
+  */
+template<class Node, class PriComp, class PriLB, class Goal>
+class PQCompactLB : public PQCompact<Node, PriComp, Goal> {
+public:
+  /** Default Constructor
+    */
+  PQCompactLB() : PQCompact<Node, PriComp, Goal>() { }
+  /** Constructor
+    * @param id the stat identifier 
+    * @param g a bool true to log the PQ stat.
+    */
+  PQCompactLB(const Id &id, bool g=true) : PQCompact<Node, PriComp, Goal>(id,g) { }
+  /** Constructor
+    * @param st the Priority Queue statistics
+    */
+  PQCompactLB(stat *st) : PQCompact<Node, PriComp, Goal>(st) { }
+  /// Destructor
+  virtual ~PQCompactLB() { }
+};
+
+/** @}
+  */
+
 /** @defgroup SimSpPQGRP Priority Queue used in a simulation state space
  *  @name  Specific implementation of Priority queue used to manage the 
  *         node that are not ready
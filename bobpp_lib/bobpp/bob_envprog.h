@@ -344,7 +344,7 @@ protected:
 #ifdef BOBPP_ENABLE_FT
     if ( core::opt().BVal("--","-ft_rs") && AlgoEnvProg<Trait>::Level()==0 ) {
       std::cout << "EnvProg : Restoring Data\n"; 
-      DeSerialFile fti(core::opt().SVal("--","-ft_file"));
+      DeSerialMap fti(core::opt().SVal("--","-ft_file"));
       if ( !fti.is_open() ) {
          std::cout << "EnvProg : File "<<core::opt().SVal("--","-ft_file")<<" not found (exit)\n"; 
          exit(1);
@@ -383,12 +383,14 @@ protected:
 #ifdef BOBPP_ENABLE_FT
     if (al->isEtStop() && AlgoEnvProg<Trait>::state_is_save() && AlgoEnvProg<Trait>::Level()==0 ) {
       std::cout << "EnvProg : algo is stopped, save data\n"; 
-      SerialFile fto(core::opt().SVal("--","-ft_file"));
+      SerialBuf fto;
       inst->Pack(fto);
       tg->Pack(fto);
       pq->Pack(fto);
       st->Pack(fto);
-      fto.close();
+      if ( !fto.write(core::opt().SVal("--","-ft_file")) ) {
+         std::cout << "EnvProg : could not write the file "<<core::opt().SVal("--","-ft_file")<<"\n"; 
+      }
       std::cout << "EnvProg : Data are saved\n"; 
     }
 #endif
@@ -418,6 +420,10 @@ class SeqBBAlgoEnvProg : public SeqAlgoEnvProg<Trait>{
   typedef typename Trait::PriComp ThePriComp;
   typedef PQInterface<TheNode,ThePriComp,TheGoal> ThePQ;
   typedef PQHn<TheNode,ThePriComp,TheGoal> TheRPQ;
+  typedef PQHk<TheNode,ThePriComp,TheGoal> TheKPQ;
+  typedef PQBucket<TheNode,ThePriComp,TheGoal> TheBPQ;
+  typedef PQSpill<TheNode,ThePriComp,TheGoal> TheSPQ;
+  typedef PQCompact<TheNode,ThePriComp,TheGoal> TheCPQ;
 
 public:
   /// Constructor
@@ -427,8 +433,13 @@ public:
   virtual ~SeqBBAlgoEnvProg() {}
 protected:
   /** Allocate the real Priority Queue
+    * The priority queue is chosen with the -- -pq option.
     */
   virtual ThePQ *alloc_pq(const Id &id) { 
+       if ( core::get_pq_type()=="hk" ) return new TheKPQ(id);
+       if ( core::get_pq_type()=="bk" ) return new TheBPQ(id);
+       if ( core::get_pq_type()=="sp" ) return new TheSPQ(id);
+       if ( core::get_pq_type()=="cp" ) return new TheCPQ(id);
        return new TheRPQ(id);
   }
   /** Initialize the instance.
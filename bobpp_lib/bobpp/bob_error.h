@@ -139,6 +139,18 @@ public:
       : Exception(" Reference Exception:", msg) {}
 };
 
+/** IO Exception. An object of this class is throwed
+ * when a file could not be read or written.
+*/
+class IOException: public Exception {
+public:
+  /** Constructor
+  * @param msg the message to display
+  */
+  IOException(const std::string& msg)
+      : Exception(" IO Exception:", msg) {}
+};
+
 /** User Exception. Simple exception class for the user side.
 */
 class UserException: public Exception {
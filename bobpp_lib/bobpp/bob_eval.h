@@ -77,6 +77,12 @@ public :
   T getEval() const {
     return val;
   }
+  /** Method to returns the evaluation as a key where the smaller is the better.
+    * This key is used by the priority queues with inline keys (see PQHk).
+    */
+  double pri_key() const {
+    return (Compare::Sens()==1 ? -(double)val : (double)val);
+  }
   /// Operator to compare two evaluations.
   bool operator==(const ThisEval &t1) const {
     return Compare::isEq(val, t1.val);
@@ -16,6 +16,10 @@
  * =====================================================================================
  */
 #include<bobpp>
+#include<cstdio>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
 
 namespace Bob {
 
@@ -89,4 +93,67 @@ void UnPack(DeSerialize &s, std::string *t, int nb) {
   s.UnPack(t, nb);
 }
 
+void SerialBuf::alloc(size_t sz) {
+  if (sz <= cap) return;
+  size_t pos = size();
+  size_t nc = (cap == 0 ? 4096 : cap);
+  while (nc < sz) nc *= 2;
+  char *nb = (char *)realloc(b, nc);
+  if (nb == 0) {
+    perror("SerialBuf::alloc");
+    exit(1);
+  }
+  b = nb;
+  cap = nc;
+  fb = b + pos;
+  fe = b + cap;
+}
+
+bool SerialBuf::write(std::string const &s) const {
+  FILE *f = fopen(s.c_str(), "wb");
+  if (f == 0) return false;
+  size_t n = fwrite(b, 1, size(), f);
+  return (fclose(f) == 0 && n == size());
+}
+
+bool SerialBuf::write_atomic(std::string const &s) const {
+  std::string t = s + ".tmp";
+  FILE *f = fopen(t.c_str(), "wb");
+  if (f == 0) return false;
+  size_t n = fwrite(b, 1, size(), f);
+  bool ok = (fflush(f) == 0 && fsync(fileno(f)) == 0 && n == size());
+  ok = (fclose(f) == 0) && ok;
+  if (!ok || rename(t.c_str(), s.c_str()) != 0) {
+    unlink(t.c_str());
+    return false;
+  }
+  return true;
+}
+
+void DeSerialMap::open(std::string const &s) {
+  struct ::stat st;
+  close();
+  int fd = ::open(s.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m != MAP_FAILED) {
+      b = (const char *)m;
+      sz = st.st_size;
+      mapped = true;
+      rb = b;
+      re = b + sz;
+    }
+  }
+  ::close(fd);
+}
+
+void DeSerialMap::close() {
+  if (mapped) munmap((void *)b, sz);
+  mapped = false;
+  b = 0;
+  sz = 0;
+  rb = re = 0;
+}
+
 };
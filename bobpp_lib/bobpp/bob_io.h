@@ -7,6 +7,8 @@
 #define BOBIO_ABSTRACT
 
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
 
 
 
@@ -80,6 +82,18 @@ namespace Bob {
  *  \endcode
  *  The goal was to unify the call to pack/unpack, for scalar types and classes.
  *
+ *  Each Pack/UnPack call on a Serialize/DeSerialize object is a virtual call.
+ *  The PackPOD and UnPackPOD methods copy an array of plain data without virtual call
+ *  when the object works on a memory buffer (Bob::SerialBuf and Bob::DeSerialMap),
+ *  and call the Pack/UnPack methods for char arrays otherwise. The data packed with
+ *  PackPOD must be unpacked with UnPackPOD.
+ *  The PackVar and UnPackVar methods store integers with a variable number of bytes
+ *  (7 bits per byte), small non negative values only need one byte. They are used to
+ *  store the nodes in a compact form (see Bob::PQCompact).
+ *  The Bob::SerialBuf serializes the data in a contiguous growable buffer that
+ *  could be written at once in a file, and the Bob::DeSerialMap deserializes the data from
+ *  a memory mapped file or from a memory buffer.
+ *
  *  @ingroup IOGRP
  *  @{
  */
@@ -87,11 +101,59 @@ namespace Bob {
 /** The abstract struture to serialize data
  */
 struct Serialize {
+protected:
+  /// the current position in the memory buffer (0 if there is no memory buffer)
+  char *fb;
+  /// the end of the memory buffer
+  char *fe;
+  /** method called when the memory buffer is too small
+    * @param n the number of bytes to write
+    * @return true if the memory buffer could store n more bytes
+    */
+  virtual bool grow(size_t n) {
+    return false;
+  }
 public:
   /// Constructor
-  Serialize() { }
+  Serialize() : fb(0), fe(0) { }
   /// Destructor
   virtual ~Serialize() { }
+  /** Pack an array of plain data, without virtual call if the data
+    * fits in the memory buffer.
+    * @param t the array to serialize
+    * @param nb the number of elements to serialize
+    * @return the number of serialized elements
+    */
+  template<class T>
+  int PackPOD(const T *t, int nb) {
+    size_t n = nb * sizeof(T);
+    if ((size_t)(fe - fb) >= n || grow(n)) {
+      memcpy(fb, t, n);
+      fb += n;
+    } else {
+      Pack((const char *)t, (int)n);
+    }
+    return nb;
+  }
+  /** Pack an array of integers with a variable number of bytes.
+    * @param t the array to serialize
+    * @param nb the number of elements to serialize
+    * @return the number of serialized elements
+    */
+  int PackVar(const int *t, int nb) {
+    unsigned char c[5];
+    for (int i = 0; i < nb; i++) {
+      unsigned int v = (unsigned int)t[i];
+      int n = 0;
+      while (v >= 0x80) {
+        c[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+      }
+      c[n++] = (unsigned char)v;
+      PackPOD((const char *)c, n);
+    }
+    return nb;
+  }
   /// Pack method for array of bool
   virtual int Pack(const bool *n, int nb) = 0;
   /// Pack method for array of int
@@ -131,11 +193,48 @@ public:
 /** The abstract struture to deserialize data
  */
 struct DeSerialize {
+protected:
+  /// the current position in the memory buffer (0 if there is no memory buffer)
+  const char *rb;
+  /// the end of the memory buffer
+  const char *re;
 public:
   /// Constructor
-  DeSerialize() { }
+  DeSerialize() : rb(0), re(0) { }
   /// Destructor
   virtual ~DeSerialize() { }
+  /** UnPack an array of plain data, without virtual call if the data
+    * is in the memory buffer.
+    * @param t the array to deserialize
+    * @param nb the number of elements to deserialize
+    */
+  template<class T>
+  void UnPackPOD(T *t, int nb) {
+    size_t n = nb * sizeof(T);
+    if ((size_t)(re - rb) >= n) {
+      memcpy(t, rb, n);
+      rb += n;
+    } else {
+      UnPack((char *)t, (int)n);
+    }
+  }
+  /** UnPack an array of integers packed with the PackVar method.
+    * @param t the array to deserialize
+    * @param nb the number of elements to deserialize
+    */
+  void UnPackVar(int *t, int nb) {
+    unsigned char c;
+    for (int i = 0; i < nb; i++) {
+      unsigned int v = 0;
+      int s = 0;
+      do {
+        UnPackPOD((char *)&c, 1);
+        v |= (unsigned int)(c & 0x7f) << s;
+        s += 7;
+      } while ((c & 0x80) && s < 35);
+      t[i] = (int)v;
+    }
+  }
   /// Is Empty
   virtual bool IsEmpty() {
     return true;
@@ -275,6 +374,78 @@ void UnPack(DeSerialize &s, char *t, int nb = 1);
  */
 void UnPack(DeSerialize &s, std::string *t, int nb = 1);
 
+/** Global template function to pack an array of objects.
+ *  Each element is packed with the Pack function, the overloaded
+ *  functions for the scalar types pack the array in one call.
+ *  @param s the serialize object
+ *  @param t the array to serialize.
+ *  @param nb the number of elements
+ */
+template<class T>
+void PackArray(Serialize &s, const T *t, int nb) {
+  for (int i = 0; i < nb; i++) Pack(s, t + i);
+}
+/// PackArray function for bool type
+inline void PackArray(Serialize &s, const bool *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for int type
+inline void PackArray(Serialize &s, const int *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for unsigned int type
+inline void PackArray(Serialize &s, const unsigned int *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for short type
+inline void PackArray(Serialize &s, const short *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for unsigned short type
+inline void PackArray(Serialize &s, const unsigned short *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for long type
+inline void PackArray(Serialize &s, const long *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for unsigned long type
+inline void PackArray(Serialize &s, const unsigned long *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for long long type
+inline void PackArray(Serialize &s, const long long *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for unsigned long long type
+inline void PackArray(Serialize &s, const unsigned long long *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for float type
+inline void PackArray(Serialize &s, const float *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for double type
+inline void PackArray(Serialize &s, const double *t, int nb) { s.Pack(t, nb); }
+/// PackArray function for char type
+inline void PackArray(Serialize &s, const char *t, int nb) { s.Pack(t, nb); }
+
+/** Global template function to unpack an array of objects.
+ *  Each element is unpacked with the UnPack function, the overloaded
+ *  functions for the scalar types unpack the array in one call.
+ *  @param s the deserialize object
+ *  @param t the array to deserialize.
+ *  @param nb the number of elements
+ */
+template<class T>
+void UnPackArray(DeSerialize &s, T *t, int nb) {
+  for (int i = 0; i < nb; i++) UnPack(s, t + i);
+}
+/// UnPackArray function for bool type
+inline void UnPackArray(DeSerialize &s, bool *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for int type
+inline void UnPackArray(DeSerialize &s, int *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for unsigned int type
+inline void UnPackArray(DeSerialize &s, unsigned int *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for short type
+inline void UnPackArray(DeSerialize &s, short *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for unsigned short type
+inline void UnPackArray(DeSerialize &s, unsigned short *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for long type
+inline void UnPackArray(DeSerialize &s, long *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for unsigned long type
+inline void UnPackArray(DeSerialize &s, unsigned long *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for long long type
+inline void UnPackArray(DeSerialize &s, long long *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for unsigned long long type
+inline void UnPackArray(DeSerialize &s, unsigned long long *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for float type
+inline void UnPackArray(DeSerialize &s, float *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for double type
+inline void UnPackArray(DeSerialize &s, double *t, int nb) { s.UnPack(t, nb); }
+/// UnPackArray function for char type
+inline void UnPackArray(DeSerialize &s, char *t, int nb) { s.UnPack(t, nb); }
+
 
 /** The structure to serialize data on a file (ofstream)
  */
@@ -462,6 +633,215 @@ protected:
   std::ifstream f;
 };
 
+/** The structure to serialize data in a contiguous memory buffer.
+ * The buffer grows when needed, all the Pack methods are a memcpy in the buffer.
+ * The content of the buffer could be written in a file at once with the write() method.
+ */
+struct SerialBuf : public Serialize {
+public:
+  /** Constructor
+    * @param sz the initial size of the buffer
+    */
+  SerialBuf(size_t sz = 65536) : Serialize(), b(0), cap(0) {
+    alloc(sz);
+  }
+  /// Destructor
+  ~SerialBuf() {
+    free(b);
+  }
+  /// get the serialized data
+  const char *data() const {
+    return b;
+  }
+  /// get the size of the serialized data
+  size_t size() const {
+    return fb - b;
+  }
+  /// empty the buffer
+  void reset() {
+    fb = b;
+  }
+  /** write the content of the buffer in a file
+    * @param s the name of the file
+    * @return true if the file has been written
+    */
+  bool write(std::string const &s) const;
+  /** write the content of the buffer in a file, the file is replaced
+    * only when the data are on the disk : the buffer is written in
+    * a temporary file (s.tmp) which is renamed.
+    * @param s the name of the file
+    * @return true if the file has been written
+    */
+  bool write_atomic(std::string const &s) const;
+
+  /// Pack method for array of bool
+  virtual int Pack(const bool *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of int
+  virtual int Pack(const int *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of unsigned int
+  virtual int Pack(const unsigned int *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of short
+  virtual int Pack(const short *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of unsigned short
+  virtual int Pack(const unsigned short *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of long
+  virtual int Pack(const long *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of unsigned long
+  virtual int Pack(const unsigned long *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of long long
+  virtual int Pack(const long long *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of unsigned long long
+  virtual int Pack(const unsigned long long *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of float
+  virtual int Pack(const float *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of double
+  virtual int Pack(const double *n, int nb) {
+    return PackPOD(n, nb);
+  }
+  /// Pack method for array of char
+  virtual int Pack(const char *s, int nb) {
+    return PackPOD(s, nb);
+  }
+  using Serialize::Pack;
+protected:
+  /// the buffer
+  char *b;
+  /// the size of the buffer
+  size_t cap;
+  /** allocates the buffer
+    * @param sz the minimum size of the buffer
+    */
+  void alloc(size_t sz);
+  /** grows the buffer
+    * @param n the number of bytes to write
+    */
+  virtual bool grow(size_t n) {
+    alloc(size() + n);
+    return true;
+  }
+};
+
+/** The structure to deserialize data from a memory buffer or from a file.
+ * The file is mapped in memory, all the UnPack methods are a memcpy from the buffer.
+ */
+struct DeSerialMap : public DeSerialize {
+public:
+  /// Constructor
+  DeSerialMap() : DeSerialize(), b(0), sz(0), mapped(false) {
+  }
+  /** Constructor
+    * @param s the name of the file
+    */
+  DeSerialMap(std::string const &s) : DeSerialize(), b(0), sz(0), mapped(false) {
+    open(s);
+  }
+  /** Constructor
+    * @param _b the memory buffer that stores the serialized data
+    * @param _sz the size of the memory buffer
+    */
+  DeSerialMap(const char *_b, size_t _sz) : DeSerialize(), b(_b), sz(_sz), mapped(false) {
+    rb = b;
+    re = b + sz;
+  }
+  /// Destructor
+  ~DeSerialMap() {
+    close();
+  }
+  /** maps the file in memory
+    * @param s the name of the file
+    */
+  void open(std::string const &s);
+  /// unmaps the file
+  void close();
+  /// test if the file is mapped.
+  bool is_open() { return b != 0; }
+  /// Is Empty
+  virtual bool IsEmpty() {
+    return rb >= re;
+  }
+  /// UnPack method for array of bool
+  virtual void UnPack(bool *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of int
+  virtual void UnPack(int *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of unsigned int
+  virtual void UnPack(unsigned int *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of short
+  virtual void UnPack(short *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of unsigned short
+  virtual void UnPack(unsigned short *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of long
+  virtual void UnPack(long *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of unsigned long
+  virtual void UnPack(unsigned long *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of long long
+  virtual void UnPack(long long *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of unsigned long long
+  virtual void UnPack(unsigned long long *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of float
+  virtual void UnPack(float *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /// Unpack method for array of double
+  virtual void UnPack(double *n, int nb) {
+    UnPackPOD(n, nb);
+  }
+  /** Unpack method for array of char
+    * If the buffer does not store enough data, the remaining chars are set to 0.
+    */
+  virtual void UnPack(char *s, int nb) {
+    size_t n = (size_t)(re - rb) < (size_t)nb ? (size_t)(re - rb) : (size_t)nb;
+    memcpy(s, rb, n);
+    memset(s + n, 0, nb - n);
+    rb += n;
+  }
+  using DeSerialize::UnPack;
+protected:
+  /// the buffer
+  const char *b;
+  /// the size of the buffer
+  size_t sz;
+  /// true if the buffer is a mapped file
+  bool mapped;
+};
+
 /**
  * @}
  */
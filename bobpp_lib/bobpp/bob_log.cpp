@@ -5,7 +5,9 @@
 #ifndef WIN32
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
+#include <fcntl.h>
 #endif
 
 namespace Bob {
@@ -137,6 +139,59 @@ void Log_net::nolock_out_wot(strbuff<> const &lm) {
 
 #endif
 
+/********************************** Metrics_out *******************************/
+#ifndef WIN32
+bool Metrics_out::open(const std::string &d, long m) {
+  close();
+  dest = d;
+  maxsz = m;
+  sock = dest.compare(0, 5, "unix:") == 0;
+  return reopen();
+}
+
+bool Metrics_out::reopen() {
+  if (sock) {
+    struct sockaddr_un adr;
+    std::string path = dest.substr(5);
+    if (path.size() >= sizeof(adr.sun_path)) return false;
+    fd = socket(PF_UNIX, SOCK_DGRAM, 0);
+    if (fd == -1) return false;
+    memset(&adr, 0, sizeof(adr));
+    adr.sun_family = AF_UNIX;
+    strcpy(adr.sun_path, path.c_str());
+    if (connect(fd, (struct sockaddr*)&adr, sizeof(adr)) == -1) {
+      ::close(fd);
+      fd = -1;
+      return false;
+    }
+    return true;
+  }
+  fd = ::open(dest.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd == -1) return false;
+  sz = lseek(fd, 0, SEEK_END);
+  return true;
+}
+
+void Metrics_out::write(const std::string &l) {
+  if (fd == -1) return;
+  if (sock) {
+    send(fd, l.c_str(), l.size(), MSG_DONTWAIT);
+    return;
+  }
+  if (maxsz > 0 && sz + (long)l.size() > maxsz) {
+    ::close(fd);
+    rename(dest.c_str(), (dest + ".1").c_str());
+    if (!reopen()) return;
+  }
+  if (::write(fd, l.c_str(), l.size()) > 0) sz += l.size();
+}
+
+void Metrics_out::close() {
+  if (fd != -1) ::close(fd);
+  fd = -1;
+}
+#endif
+
 /********************************** Log used in CORE *******************************/
 Log::Log(): Log_base(),l(new Log_base()) {
 };
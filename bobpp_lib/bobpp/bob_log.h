@@ -384,6 +384,50 @@ protected:
   Log_base *l;
 };
 
+#ifndef WIN32
+/** The Metrics_out class
+ * This class writes the lines of the metrics sampler (see the -- -mf option).
+ * The destination is a file, which is renamed with the ".1" suffix when its size 
+ * exceeds a maximum size, or a Unix socket with the "unix:path" syntax. 
+ * In the latter case each line is sent as a datagram, and a line is lost 
+ * if the reader is not ready.
+ */
+class Metrics_out {
+protected:
+  /// the destination
+  std::string dest;
+  /// the file descriptor (-1 if the destination is not open)
+  int fd;
+  /// true if the destination is a Unix socket
+  bool sock;
+  /// the maximum size of the file
+  long maxsz;
+  /// the current size of the file
+  long sz;
+  /// open the file or the socket
+  bool reopen();
+public:
+  /// Constructor
+  Metrics_out() : dest(), fd(-1), sock(false), maxsz(0), sz(0) { }
+  /// Destructor
+  ~Metrics_out() { close(); }
+  /** open the destination
+    * @param d the file name or unix:path for a Unix socket
+    * @param m the maximum size of the file in bytes (0 for no rotation)
+    * @return true if the destination is open
+    */
+  bool open(const std::string &d, long m);
+  /** write a line
+    * @param l the line to write
+    */
+  void write(const std::string &l);
+  /// close the destination
+  void close();
+  /// test if the destination is open
+  bool is_open() const { return fd != -1; }
+};
+#endif
+
 /**
  * @}
  */
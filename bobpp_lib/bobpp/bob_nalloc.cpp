@@ -0,0 +1,199 @@
+#include <bobpp>
+#include <new>
+
+
+namespace Bob {
+
+/// alignment and granularity of the size classes
+#define NP_ALIGN 16
+/// number of size classes
+#define NP_NBCLASS 64
+/// size of a slab
+#define NP_SLAB (64*1024)
+
+struct NPCache;
+
+/** Header stored before each block
+  */
+struct NPHeader {
+  /// the cache that owns the block (0 if the block is allocated by the system).
+  NPCache *owner;
+  /// the size class of the block
+  long cls;
+};
+
+/** a free block
+  */
+struct NPBlock {
+  /// the next free block
+  NPBlock *next;
+};
+
+/** The cache of a thread
+  */
+struct NPCache {
+  /// the local free lists
+  NPBlock *fl[NP_NBCLASS];
+  /// the remote free lists
+  NPBlock * volatile rem[NP_NBCLASS];
+  /// the current slab
+  char *slab;
+  /// the free space in the current slab
+  size_t sfree;
+  /// the list of the slabs, each slab begins with a pointer to the previous one
+  char *slabs;
+  /// the number of allocated blocks
+  long long nba;
+  /// the number of allocated bytes
+  long long nbb;
+  /// the number of blocks released by the owner thread
+  long long nbf;
+  /// the number of blocks released by the other threads
+  volatile long long nbr;
+  /// true if the owner thread is ended
+  bool retired;
+  /// the next cache in the list of all the caches
+  NPCache *next;
+  /// Constructor
+  NPCache() : slab(0), sfree(0), slabs(0), nba(0), nbb(0), nbf(0), nbr(0), retired(false), next(0) {
+    for (int i = 0; i < NP_NBCLASS; i++) {
+      fl[i] = 0;
+      rem[i] = 0;
+    }
+  }
+  /// Destructor, the slabs are returned to the system
+  ~NPCache() {
+    while (slabs != 0) {
+      char *s = slabs;
+      slabs = *(char **)s;
+      ::operator delete((void *)s);
+    }
+  }
+  /// true if all the allocated blocks are released
+  bool unused() const {
+    return nba == nbf + nbr;
+  }
+};
+
+/// the cache of the calling thread
+static __thread NPCache *np_cache = 0;
+/// the list of all the caches
+static NPCache *np_all = 0;
+/// the lock of the list of the caches
+static volatile int np_lock = 0;
+
+/// lock the list of the caches
+static void np_lock_all() {
+  while (__sync_lock_test_and_set(&np_lock, 1)) ;
+}
+
+/// unlock the list of the caches
+static void np_unlock_all() {
+  __sync_lock_release(&np_lock);
+}
+
+/// get the cache of the calling thread
+static NPCache *np_get() {
+  if (np_cache == 0) {
+    np_cache = new NPCache();
+    np_lock_all();
+    np_cache->next = np_all;
+    np_all = np_cache;
+    np_unlock_all();
+  }
+  return np_cache;
+}
+
+void *NodePool::alloc(size_t sz) {
+  NPHeader *h;
+  long cls = (sz + NP_ALIGN - 1) / NP_ALIGN - 1;
+  if (!core::node_pool() || cls >= NP_NBCLASS) {
+    h = (NPHeader *)::operator new(sz + sizeof(NPHeader));
+    h->owner = 0;
+    h->cls = -1;
+    return (void *)(h + 1);
+  }
+  NPCache *c = np_get();
+  NPBlock *b = c->fl[cls];
+  if (b == 0 && c->rem[cls] != 0) {
+    b = (NPBlock *)__sync_lock_test_and_set(&(c->rem[cls]), (NPBlock *)0);
+  }
+  if (b != 0) {
+    c->fl[cls] = b->next;
+    h = ((NPHeader *)b) - 1;
+  } else {
+    size_t bsz = sizeof(NPHeader) + (cls + 1) * NP_ALIGN;
+    if (c->sfree < bsz) {
+      char *s = (char *)::operator new(NP_SLAB);
+      *(char **)s = c->slabs;
+      c->slabs = s;
+      c->slab = s + NP_ALIGN;
+      c->sfree = NP_SLAB - NP_ALIGN;
+    }
+    h = (NPHeader *)c->slab;
+    c->slab += bsz;
+    c->sfree -= bsz;
+    h->owner = c;
+    h->cls = cls;
+  }
+  c->nba++;
+  c->nbb += (cls + 1) * NP_ALIGN;
+  return (void *)(h + 1);
+}
+
+void NodePool::release(void *p) {
+  if (p == 0) return;
+  NPHeader *h = ((NPHeader *)p) - 1;
+  NPCache *o = h->owner;
+  if (o == 0) {
+    ::operator delete((void *)h);
+    return;
+  }
+  NPBlock *b = (NPBlock *)p;
+  if (o == np_cache) {
+    b->next = o->fl[h->cls];
+    o->fl[h->cls] = b;
+    o->nbf++;
+    return;
+  }
+  NPBlock *old;
+  do {
+    old = o->rem[h->cls];
+    b->next = old;
+  } while (!__sync_bool_compare_and_swap(&(o->rem[h->cls]), old, b));
+  __sync_add_and_fetch(&(o->nbr), 1);
+}
+
+void NodePool::thread_end() {
+  if (np_cache == 0) return;
+  np_cache->retired = true;
+  np_cache = 0;
+}
+
+void NodePool::reclaim() {
+  NPCache **pc, *c;
+  if (np_cache != 0) np_cache->retired = true;
+  np_lock_all();
+  pc = &np_all;
+  while ((c = *pc) != 0) {
+    if (c->retired && c->unused()) {
+      *pc = c->next;
+      if (c == np_cache) np_cache = 0;
+      delete c;
+    } else {
+      pc = &(c->next);
+    }
+  }
+  if (np_cache != 0) np_cache->retired = false;
+  np_unlock_all();
+}
+
+long long NodePool::nb_alloc() {
+  return np_get()->nba;
+}
+
+long long NodePool::nb_bytes() {
+  return np_get()->nbb;
+}
+
+}
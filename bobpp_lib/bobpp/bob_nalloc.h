@@ -0,0 +1,73 @@
+/*
+ * bobpp/bob_nalloc.h
+ *
+ * This source include the allocator used for the nodes of the search space.
+ */
+
+#ifndef BOBNALLOC
+#define BOBNALLOC
+
+#include <cstddef>
+
+namespace Bob {
+
+/** @defgroup NodeAllocGRP The node allocator
+ *  @ingroup CoreGRP
+ *  @brief This module describes the per-thread allocator used for the nodes.
+ *  @{
+ *
+ *  During a search, the nodes are allocated and deleted at a high rate, often by
+ *  different threads : a node is allocated by the thread that generates it, and it
+ *  is deleted by the thread that drops the last reference on it.
+ *  The Bob::NodePool allocates the nodes in per-thread slabs. Each thread
+ *  has one free list per size class (multiple of 16 bytes up to 1024 bytes).
+ *  A block freed by another thread is pushed on a lock-free remote free list of
+ *  the owner thread, which is emptied by the owner when its local free list is empty.
+ *
+ *  The base_Node class uses this allocator through its operator new and delete.
+ *  The node pool is not used with the -- -sa option.
+ *
+ *  The slabs of a thread are returned to the system when the thread is ended
+ *  and all the blocks it has allocated are released (NodePool::reclaim(), called by
+ *  ThrEnvProg::end() and by core::End()). The slabs of a cache that still has live 
+ *  blocks (a node kept by the user, a leaked node) are kept until a later reclaim.
+ */
+
+/** The per-thread node pool.
+ *  All the methods are static.
+ */
+class NodePool {
+public:
+  /** Allocates a block
+    * @param sz the size of the block
+    * @return the allocated block
+    */
+  static void *alloc(size_t sz);
+  /** Releases a block allocated by the alloc method
+    * @param p the block to release
+    */
+  static void release(void *p);
+  /** Get the number of blocks allocated by the calling thread
+    * @return the number of allocated blocks
+    */
+  static long long nb_alloc();
+  /** Get the number of bytes allocated by the calling thread
+    * @return the number of allocated bytes
+    */
+  static long long nb_bytes();
+  /** Marks the cache of the calling thread as ended, it is called by a thread before its end.
+    * The cache is freed by the next reclaim() when all its blocks are released.
+    */
+  static void thread_end();
+  /** Returns to the system the slabs of the ended threads whose blocks are all released,
+    * and the slabs of the calling thread if its blocks are all released.
+    */
+  static void reclaim();
+};
+
+/**
+ * @}
+ */
+
+}
+#endif
@@ -42,6 +42,19 @@ public:
     return true;
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return 0.0;
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return false;
+  }
 };
 
 /** The best first priority
@@ -70,6 +83,19 @@ public:
     return (e1 > e2 ? 1 : (e1 == e2 ? e1.dist() > e2.dist() : 0));
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return e.pri_key();
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return true;
+  }
 };
 
 /** The best first priority
@@ -98,6 +124,19 @@ public:
     return (e1 > e2 ? 1 : (e1 == e2 ? e1.dist() < e2.dist() : 0));
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return e.pri_key();
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return true;
+  }
 };
 
 /** the Depth first priority
@@ -123,6 +162,19 @@ public:
     return e1.dist() > e2.dist();
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return -(double)e.dist();
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return false;
+  }
 };
 
 
@@ -150,6 +202,19 @@ public:
     return e1.dist() < e2.dist();
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return (double)e.dist();
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return false;
+  }
 };
 
 /** Breath first Search
@@ -174,6 +239,19 @@ public:
     return e1.dist() < e2.dist();
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return (double)e.dist();
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return false;
+  }
 };
 
 
@@ -200,6 +278,19 @@ public:
     return e1.dist() > e2.dist() || (e1.dist() == e2.dist() && e1 > e2);
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return -(double)e.dist();
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return false;
+  }
 };
 
 /** the best first, then depth first priority
@@ -229,6 +320,69 @@ public:
       return e1 > e2;
   }
 
+  /**  inline key used by the priority queues with inline keys (see PQHk)
+  * @param e the node
+  * @return the key, if e1 is better than e2 then key(e1)<=key(e2).
+  */
+  static double key(const T &e) {
+    return 0.0;
+  }
+  /** test if the inline key only depends on the evaluation of the node
+  * @return true if two nodes with the same key are pruned or kept together by the goal.
+  */
+  static bool isEvalKey() {
+    return false;
+  }
+};
+
+/** Test if a node has an inline key (see Eval::pri_key()).
+ * The nodes without evaluation (the nodes of a CDC search for instance) have no key.
+ * @ingroup PriGRP
+ */
+template<class T>
+struct HasPriKey {
+  /// type returned by the test method if the node has a key
+  typedef char yes;
+  /// type returned by the test method if the node has no key
+  typedef long no;
+  /// selected if U::pri_key() is defined
+  template<class U>
+  static yes test(char (*)[sizeof(((const U *)0)->pri_key())]);
+  /// selected otherwise
+  template<class U>
+  static no test(...);
+  /// true if the node has a key
+  enum { value = (sizeof(test<T>(0)) == sizeof(yes)) };
+};
+
+/** Get the key of a node for the bound of the search.
+ * The key is the inline key of the priority (see BestEPri::key()) if it only 
+ * depends on the evaluation, otherwise -HUGE_VAL (no bound).
+ * The key of the priority is only instantiated when the node has an 
+ * inline key, a priority could then be used with any node without bound.
+ * @ingroup PriGRP
+ */
+template<class T, class PriComp, bool K = HasPriKey<T>::value>
+struct BoundKey {
+  /** get the key
+  * @param e the node
+  */
+  static double key(const T &e) {
+    return (PriComp::isEvalKey() ? PriComp::key(e) : -HUGE_VAL);
+  }
+};
+
+/** Get the key of a node without inline key : there is no bound.
+ * @ingroup PriGRP
+ */
+template<class T, class PriComp>
+struct BoundKey<T, PriComp, false> {
+  /** get the key
+  * @param e the node
+  */
+  static double key(const T &e) {
+    return -HUGE_VAL;
+  }
 };
 };
 
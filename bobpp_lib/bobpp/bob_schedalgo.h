@@ -6,6 +6,7 @@
  */
 
 #include <string>
+#include <deque>
 
 
 #ifndef BOBSCHEDALGO_HEADER
@@ -550,6 +551,57 @@ public:
   virtual void stat_merge(long l = 0) {
     st.merge(l);
   }
+  /** Write the metrics of the goal as key=value fields (see the -- -mf option).
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) {
+    os << " sols=" << st.peek_counter('s') << " upd=" << st.peek_counter('u');
+  }
+  /** Write the bound of the search and the gap with the goal (see the -- -mf option).
+    * @param os the std::ostream used to write the metrics
+    * @param bk the bound of the search as a key (see PQInterface::BestKey())
+    */
+  virtual void MetricsBound(std::ostream &os, double bk) { }
+  /** Test if the search could be ended since the bound of the search is 
+    * close enough to the goal (see the --bb -gap option).
+    * The method is called without locking the goal.
+    * @param bk the bound of the search as a key (see PQInterface::BestKey())
+    * @return true if all the pending nodes could be removed.
+    */
+  virtual bool isClosed(double bk) {
+    return false;
+  }
+  /** Get the key of the incumbent used to prune the nodes, it could be the key
+    * of a solution found by another process (see update_key()).
+    * The method is called without locking the goal.
+    * @return HUGE_VAL if the goal does not prune the nodes with a key.
+    */
+  virtual double inc_key() {
+    return HUGE_VAL;
+  }
+  /** Tighten the key used to prune the nodes with the key of a solution
+    * found by another process, the solution itself is not known.
+    * The method is called without locking the goal.
+    * @param k the key of the solution (see Eval::pri_key())
+    * @return true if the key used to prune the nodes is improved.
+    */
+  virtual bool update_key(double k) {
+    return false;
+  }
+  /** Test if the node is pruned by the key of the incumbent (see inc_key()).
+    * The method is called without locking the goal.
+    * @param n the node to test
+    * @return true if the node could not lead to a better solution.
+    */
+  virtual bool is_pruned(TheNode *n) {
+    return false;
+  }
+  /** Test if the goal stores the solution of the key of the incumbent,
+    * used to collect the solution at the end of a distributed search.
+    */
+  virtual bool holds_inc() {
+    return true;
+  }
   /** Pack method to Serialize the SchedNode
    * @param bs the DeSerialize object
    */
@@ -576,11 +628,140 @@ protected:
   bool verb;
 };
 
+/**
+ * The TreeProfile estimates online the size of the search tree.
+ * The profile counts per depth (see base_Node::dist()) the explored nodes,
+ * the children kept for the search and the kept nodes pruned when they are 
+ * deleted. The size of a subtree rooted at depth d is estimated from the 
+ * deepest level seen : S(d) = 1 + b(d)*r(d+1)*S(d+1), where b(d) is the number
+ * of children kept per explored node of depth d, and r(d) the ratio of the 
+ * kept nodes of depth d that are explored. The size of the tree is S(0).
+ * The estimate needs the depth of the children to be set by the GenChild
+ * (the depth of the parent plus 1), otherwise valid() returns false.
+ * A profile is owned by one thread and its counters are plain integers,
+ * except for a profile shared by several threads (see SubtreeLoad) that is
+ * built with the shared flag and updated with atomic operations.
+ * The counters are read without synchronization.
+ */
+class TreeProfile {
+public:
+  /// the number of depths, the deeper nodes are counted with the last depth
+  enum { MAX_DEPTH = 256 };
+protected:
+  /// the number of children kept for the search per depth
+  long gen[MAX_DEPTH];
+  /// the number of explored nodes per depth
+  long exp[MAX_DEPTH];
+  /// the number of kept nodes pruned at their deletion per depth
+  long prn[MAX_DEPTH];
+  /// the maximum depth seen
+  int maxd;
+  /// true if the counters are updated by several threads
+  bool shared;
+  /// add 1 to a counter
+  void inc(long &c) {
+    if (shared) __sync_add_and_fetch(&c, 1);
+    else c++;
+  }
+public:
+  /** Constructor
+    * @param sh true if the profile is updated by several threads
+    */
+  TreeProfile(bool sh = false) : shared(sh) {
+    reset();
+  }
+  /// reset the counters
+  void reset() {
+    for (int d = 0; d < MAX_DEPTH; d++) {
+      gen[d] = exp[d] = prn[d] = 0;
+    }
+    maxd = 0;
+  }
+  /// the depth d bounded by the number of depths
+  static int dep(int d) { return (d < 0 ? 0 : (d >= MAX_DEPTH ? MAX_DEPTH - 1 : d)); }
+  /// the maximum depth seen
+  int depth() const { return maxd; }
+  /// a child of depth d is kept for the search
+  void child(int d) {
+    d = dep(d);
+    inc(gen[d]);
+    if (d > maxd) maxd = d;
+  }
+  /// a node of depth d is explored
+  void explored(int d) {
+    d = dep(d);
+    inc(exp[d]);
+    if (d > maxd) maxd = d;
+  }
+  /// a kept node of depth d is pruned when it is deleted
+  void pruned(int d) {
+    inc(prn[dep(d)]);
+  }
+  /** add the counters of another profile
+    * @param p the profile to add
+    */
+  void merge(const TreeProfile &p) {
+    for (int d = 0; d <= p.maxd; d++) {
+      gen[d] += p.gen[d];
+      exp[d] += p.exp[d];
+      prn[d] += p.prn[d];
+    }
+    if (p.maxd > maxd) maxd = p.maxd;
+  }
+  /// the number of explored nodes
+  long nb_explored() const {
+    long nb = 0;
+    for (int d = 0; d <= maxd; d++) nb += exp[d];
+    return nb;
+  }
+  /// test if the depths are set : only the root is at depth 0 and its children are at depth 1
+  bool valid() const {
+    return exp[0] > 0 && gen[0] == 0 && (maxd == 0 || gen[1] > 0);
+  }
+  /** compute the estimated sizes of the subtrees rooted at each depth
+    * @param s the array of MAX_DEPTH sizes, the depths greater than depth() are not set
+    */
+  void subtrees(double *s) const {
+    int m = maxd;
+    s[m] = 1;
+    for (int d = m - 1; d >= 0; d--) {
+      double b = (exp[d] > 0 ? (double)gen[d + 1] / exp[d] : 0);
+      long k = exp[d + 1] + prn[d + 1];
+      double r = (k > 0 ? (double)exp[d + 1] / k : 1);
+      s[d] = 1 + b * r * s[d + 1];
+      if (s[d] > 1e15) s[d] = 1e15;
+    }
+  }
+  /** get the estimated number of explored nodes of the whole tree, it is 
+    * at least the number of nodes already explored.
+    * @return 0 if the estimate is not valid
+    */
+  double estimate() const {
+    double s[MAX_DEPTH];
+    if (!valid()) return 0;
+    subtrees(s);
+    double nb = nb_explored();
+    return (s[0] < nb ? nb : s[0]);
+  }
+  /** Write the estimated size of the tree, the progress of the search (in percent)
+    * and the estimated remaining time (see the -- -mf option).
+    * @param os the std::ostream used to write the metrics
+    * @param t the elapsed time of the search
+    */
+  void Metrics(std::ostream &os, double t) const {
+    double e = estimate(), nb = nb_explored();
+    if (e <= 0 || nb <= 0) return;
+    os << " est=" << (long long)e << " done=" << (int)(100 * nb / e) << " eta=" << (long long)(t * (e - nb) / nb);
+  }
+};
+
 /**
  * The SchedStatAlgo represents the statistics for the SchedAlgo
  * it inherits from base_stat.
  */
 class SchedStat : public base_Stat {
+  /// the profile of the explored tree
+  TreeProfile prof;
 public:
   /** Constructor
    * @param n the identifier of the this algorithm
@@ -590,12 +771,29 @@ public:
     add_counter('i', "Inserted Nodes");
     add_counter('n', "Nonfeasible Nodes");
     add_counter('p', "Pruned Nodes");
+    add_counter('l', "Local Dive Nodes");
     add_timer('C', "Genchild Calls");
     add_timer('D', "PQ del Calls");
   }
   /// destructor
   virtual ~SchedStat() {
   }
+  /// get the profile of the explored tree
+  virtual const TreeProfile *profile() const {
+    return &prof;
+  }
+  /** Counts a child kept for the search in the profile of the tree
+    * @param bn the child node
+    */
+  void child(base_Node *bn) {
+    prof.child(bn->dist());
+  }
+  /** Counts a kept node pruned at its deletion in the profile of the tree
+    * @param bn the pruned node
+    */
+  void dropped(base_Node *bn) {
+    prof.pruned(bn->dist());
+  }
   /// Counts the number of generated nodes
   void start_del() {
     get_timer('D').start();
@@ -615,6 +813,7 @@ public:
     * @param bn the node used to call the genchild
     */
   void start_gc(base_Node *bn) {
+    prof.explored(bn->dist());
     get_timer('C').start(bn->id());
   }
   /// Counts the number of generated nodes
@@ -645,6 +844,12 @@ public:
       get_counter('p').add(st.str(),n);
     }
   }
+  /** Counts the number of nodes pushed on the local stack
+    * @param bn the pushed node
+    */
+  void loc(base_Node *bn) {
+    get_counter('l').add(1);
+  }
   /** Counts the number of inserted nodes
     * @param bn the inserted node
     */
@@ -686,6 +891,19 @@ public:
   *     Notice that the operator()(node *n) of the class GenChild must call the Search(Node *c)
   *     method of the algorithm to know what to do with new generated child node c
   *
+  * With the --  -ld option, the algorithm performs a local dive : the nodes to search are 
+  * pushed on a private stack and the next node is popped from this stack (depth first).
+  * A node is published to the GPQ only if the GPQ needs nodes (see PQInterface::need_node())
+  * or if the local stack exceeds the given size. In both cases the oldest node of the 
+  * stack is published. When the local stack is empty, it is refilled with a batch of
+  * the best nodes of the GPQ (see the -- -ldb option and PQInterface::DelBatch()).
+  * The nodes of the local stack are private to the thread: when the goal is updated,
+  * the stack is pruned with the GPQ (see LocDelG()), but the other threads, the load 
+  * balancing of the mpx environment (the load of a process only counts the nodes of 
+  * its GPQ), need_node() and the best bound of the GPQ do not see them. The bound 
+  * remains valid since the explored node of a thread is the ancestor of its stack, but 
+  * a process may look idle while its threads dive. The stack is published to the GPQ 
+  * before a checkpoint and at the end of the algorithm.
   */
 template <class Trait>
 class SchedAlgo : public base_Algo {
@@ -716,6 +934,14 @@ protected:
   TheGoal *goal;
   /// the GenChild class
   TheGenChild *gc;
+  /// the local stack used for the local dive
+  std::deque<TheNode *> lst;
+  /// true if the inserted nodes are buffered (during a GenChild call)
+  bool ibat;
+  /// the buffer of the nodes inserted during a GenChild call
+  std::vector<TheNode *> ibuf;
+  /// the buffer of the nodes deleted at once from the GPQ
+  std::vector<TheNode *> dbuf;
   // the current parent node
   //TheNode *parent;
 public:
@@ -728,7 +954,7 @@ public:
    */
   SchedAlgo(const TheInstance *bsia, ThePQ *_pq, TheGoal *tg, TheStat *st) :
       base_Algo(st), ia(bsia), gpq(_pq), goal(tg),
-      gc(new TheGenChild(ia, (TheAlgo *)this))/*, parent(0)*/ {
+      gc(new TheGenChild(ia, (TheAlgo *)this)), lst(), ibat(false), ibuf(), dbuf()/*, parent(0)*/ {
     BOBASSERT(gpq != 0, NullPointerException, "SchedAlgo", "GPQ is null");
     DBGAFF_MEM("SchedAlgo::SchedAlgo", "Constructor (Instance *,PQ *,Stat *)");
       //std::cout << "Schedalgo:Goal "<<typeid(*goal).name()<<"\n";
@@ -752,12 +978,24 @@ public:
     base_Algo::toRun();
     GPQ()->addRef();
     DBGAFF_ALGO("SchedAlgo::operator()", "Before the main loop");
-    while (base_Algo::isEtRun() && (n = GPQGet()) != 0) {
+    while (base_Algo::isEtRun()) {
+      if (gpq->ckpt_requested()) {
+        DBGAFF_ALGO("SchedAlgo::operator()", "Pause for a checkpoint");
+        LocFlush();
+        gpq->ckpt_pause();
+      }
+      bool fromg = lst.empty();
+      if ((n = LocGet()) == 0) break;
       DBGAFF_ALGO("SchedAlgo::operator()",
                   "We have a node and the state of the algo is ok");
+      if (fromg && ThePriComp::isEvalKey() && goal->isClosed(GPQBound(n))) {
+        DBGAFF_ALGO("SchedAlgo::operator()", "The gap is reached, the GPQ is pruned");
+        gpq->DelG(*goal);
+      }
       if (!goal->is4Search(n)) {
         DBGAFF_ALGO("SchedAlgo::operator()", "Node must be discarded");
         getStat()->prun(n,1);
+        getStat()->dropped(n);
         if (n->isDel())
           delete n;
         continue;
@@ -766,7 +1004,10 @@ public:
       getStat()->start_gc(n);
       DBGAFF_ALGO("SchedAlgo::operator()", "Call the genchild");
       n->addRef();
+      ibat = true;
       (*gc)(n);
+      ibat = false;
+      GPQFlush();
       n->remRef();
       getStat()->end_gc(n);
       if (n->isDel())
@@ -775,6 +1016,7 @@ public:
     if ( !base_Algo::isEtRun() ) {
       std::cout << "Algorithm has been stopped\n";
     } else base_Algo::toEnd();
+    LocFlush();
     GPQ()->remRef();
     base_Algo::StEnd();
     DBGAFF_ALGO("SchedAlgo::operator()", "ends !");
@@ -795,7 +1037,7 @@ public:
       n->addRef();
       if (goal->update(n)) {
         //std::cout << "Schedalgo::Search Goal "<<typeid(*goal).name()<<"\n";
-        int count = gpq->DelG(*goal);
+        int count = gpq->DelG(*goal)+LocDelG();
         if (count)
           getStat()->prun(0,count);
       }
@@ -811,7 +1053,8 @@ public:
       return false;
     }
     DBGAFF_ALGO("SchedAlgo::Search()", "Insert the node");
-    GPQIns(n);
+    getStat()->child(n);
+    LocIns(n);
     return true;
   };
   /**
@@ -822,10 +1065,21 @@ public:
   virtual ThePQ *&GPQ() {
     return gpq;
   }
-  /// inserts a Node in the GPQ
+  /** inserts a Node in the GPQ.
+    * During a GenChild call, the node is only stored in a buffer, the sibling nodes 
+    * are inserted at once by GPQFlush().
+    * @param n the node to insert
+    */
   void GPQIns(TheNode *n) {
     getStat()->ins(n);
-    GPQ()->Ins(n);
+    if ( ibat ) ibuf.push_back(n);
+    else GPQ()->Ins(n);
+  }
+  /// inserts the buffered nodes in the GPQ
+  void GPQFlush() {
+    if ( ibuf.empty() ) return;
+    GPQ()->InsBatch(&ibuf[0],ibuf.size());
+    ibuf.clear();
   }
   /// gets  a Node in the GPQ
   TheNode *GPQGet() {
@@ -835,6 +1089,94 @@ public:
     getStat()->end_del(n);
     return  n;
   }
+  /** gets a batch of at most nb Nodes in the GPQ, in the order of the priority.
+    * @param nb the maximum number of nodes
+    * @return the number of deleted nodes, stored in dbuf.
+    */
+  int GPQGet(int nb) {
+    int nbd;
+    dbuf.resize(nb);
+    getStat()->start_del();
+    nbd = GPQ()->DelBatch(&dbuf[0],nb);
+    getStat()->end_del(nbd>0 ? dbuf[0] : 0);
+    return nbd;
+  }
+  /** get the bound of the search when a node has just been deleted from the GPQ.
+    * @param n the deleted node
+    * @return the minimum of the key of n and of the best key of the GPQ.
+    */
+  double GPQBound(TheNode *n) {
+    double k = ThePriComp::key(*n), b = gpq->BestKey();
+    return (b < k ? b : k);
+  }
+  //@}
+  /**
+     @name Local dive methods.
+  */
+  //@{
+  /** inserts a Node on the local stack or in the GPQ.
+    * The node is inserted in the GPQ if the local dive is not used.
+    * When the local stack is full, its oldest node is published to the GPQ.
+    * @param n the node to insert
+    */
+  void LocIns(TheNode *n) {
+    unsigned int ld = core::get_local_dive();
+    if ( ld==0 ) { GPQIns(n); return; }
+    if ( lst.size()>=ld ) LocPublish();
+    getStat()->loc(n);
+    lst.push_back(n);
+  }
+  /** gets the next Node to explore.
+    * The node is popped from the local stack, and the oldest node of the stack 
+    * is published if the GPQ needs nodes. If the local stack is empty, a batch of
+    * nodes is deleted from the GPQ : the best one is returned and the others are 
+    * pushed on the local stack, the next best one on the top.
+    * @return the node or 0 if the search is ended.
+    */
+  TheNode *LocGet() {
+    TheNode *n;
+    if ( lst.empty() ) {
+      int ld = core::get_local_dive(), nb = core::get_local_batch();
+      if ( ld==0 || nb<=1 ) return GPQGet();
+      int nbd = GPQGet(nb < ld ? nb : ld);
+      if ( nbd==0 ) return 0;
+      for (int i=nbd-1;i>0;i-- ) {
+        getStat()->loc(dbuf[i]);
+        lst.push_back(dbuf[i]);
+      }
+      return dbuf[0];
+    }
+    if ( lst.size()>1 && GPQ()->need_node() ) LocPublish();
+    n = lst.back();
+    lst.pop_back();
+    return n;
+  }
+  /// publishes the oldest node of the local stack to the GPQ.
+  void LocPublish() {
+    TheNode *n = lst.front();
+    lst.pop_front();
+    GPQIns(n);
+  }
+  /// publishes all the nodes of the local stack to the GPQ.
+  void LocFlush() {
+    while ( !lst.empty() ) LocPublish();
+  }
+  /** removes the nodes of the local stack that are no more needed with regard to the Goal
+    * @return the number of removed nodes
+    */
+  int LocDelG() {
+    int nb=0;
+    typename std::deque<TheNode *>::iterator it=lst.begin();
+    while ( it!=lst.end() ) {
+      TheNode *n=*it;
+      if ( goal->is4Search(n) ) { ++it; continue; }
+      it=lst.erase(it);
+      getStat()->dropped(n);
+      if ( n->isDel() ) delete n;
+      nb++;
+    }
+    return nb;
+  }
   //@}
 
   /// gets the Instance
@@ -758,6 +758,29 @@ public:
   SimSpGoalStat *getStat() {
     return &st;
   }
+  /** Write the metrics of the goal (see the -- -mf option), the goal has no metrics.
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) { }
+  /** The search has no bound, nothing is written.
+    * @param os the std::ostream used to write the metrics
+    * @param bk the bound of the search as a key
+    */
+  virtual void MetricsBound(std::ostream &os, double bk) { }
+  /** The search has no pruning key, no node is pruned before the goal lock.
+    * @param n the node to test
+    */
+  virtual bool is_pruned(TheNode *n) { return false; }
+  /** The search has no pruning key.
+    */
+  virtual double inc_key() { return HUGE_VAL; }
+  /** The search has no pruning key, the remote key is ignored.
+    * @param k the key received from another process
+    */
+  virtual bool update_key(double k) { return false; }
+  /** The goal always holds its own best solution.
+    */
+  virtual bool holds_inc() { return true; }
   /** write the stat header on the log
     */
   virtual void log_header() { getStat()->log_header(); }
@@ -8,34 +8,49 @@
 
 namespace Bob {
 
+#define COUN_SP 6
+#define TIME_SP 10
+
 void stat_timer::start() {
   dt = 0L;
   nbr++;
-  st = core::dTime();
-  core::log().out(str(), 's', nbr,cumt);
+  st = core::mTime();
+  if ( is_logged() ) core::log().out(str(), 's', nbr,cumt);
 }
 
 /// Set the end time
 void stat_timer::end() {
-  dt = core::dTime(st);
+  dt = core::mTime() - st;
   cumt += dt;
+  record(dt);
   if ( is_logged() ) core::log().out(str(), 'e', nbr,cumt);
 }
 
 void stat_timer::start(node_id id) {
   dt = 0L;
   nbr++;
-  st = core::dTime();
+  st = core::mTime();
   if ( is_logged() ) core::log().out(str(), 's', nbr,cumt,id);
 }
 
 /// Set the end time
 void stat_timer::end(node_id id) {
-  dt = core::dTime(st);
+  dt = core::mTime() - st;
   cumt += dt;
+  record(dt);
   if ( is_logged() ) core::log().out(str(), 'e', nbr,cumt,id);
 }
 
+void stat_timer::display_histo(ostream &os) const {
+  std::stringstream ss(stringstream::in | stringstream::out);
+  ss << std::setw(TIME_SP) << id() << " (k: ns<2^k) ";
+  for (int k = 0; k < NbH; k++) {
+    if (hist[k] != 0) ss << k << ":" << hist[k] << " ";
+  }
+  ss << std::endl;
+  os << ss.str();
+}
+
 void stat_counter::update_log() {
   update_mix();
   if ( is_logged() ) core::log().out(str(), nb);
@@ -72,8 +87,6 @@ void stat::merge(const stat &s) {
   }
 }
 
-#define COUN_SP 6
-#define TIME_SP 10
 
 /* Dispaly of stat counters */
 void format_label(std::stringstream &os, const stat_counter &st) {
@@ -172,6 +185,12 @@ void stat::display_data(ostream &os,const char *lib,int size) {
 }
 
 
+void stat::display_histo(ostream &os) {
+  for (MapTime::const_iterator i = mt.begin(); i != mt.end() ; i++) {
+    if (i->second.getn() > 0) i->second.display_histo(os);
+  }
+}
+
 void stat::Pack(Serialize &bs) const {
   int nb;
   DBGAFF_PCK("stat::Pack", "Packing stat");
@@ -18,6 +18,8 @@ namespace Bob {
  *
  *  We have choosen to store time statistics (@ref stat_timer)
  *  We have choosen to store counter (@ref stat_counter)
+ *  The timers use a monotonic clock and also store a log-scale histogram of the
+ *  measured durations, which is displayed with the -- -sh option.
  *  The class stat could store several stat_timer, stat_counter
  *  and also pointers on other stat objects.
  *
@@ -136,10 +138,14 @@ public:
  * or something. It stores an identifier the methods start() and end() may
  * be used to indicate the beginning and the end of the component we want
  * to profile.
- * These methods use the core::dtime() method to get the time.
+ * These methods use the core::mTime() method to get the time.
+ * Each duration is also counted in a log-scale histogram: the bucket k 
+ * counts the durations between 2^(k-1) and 2^k nanoseconds.
  *
  */
 class stat_timer : public stat_base {
+public:
+  enum { NbH = 40 /*!< number of buckets of the histogram */ };
 protected:
   /// The number of runs
   unsigned long long nbr;
@@ -151,22 +157,37 @@ protected:
   double dt;
   /// cumulating timers
   double cumt;
+  /// the histogram of the durations
+  unsigned long long hist[NbH];
+
+  /** count a duration in the histogram
+    * @param d the duration in seconds
+    */
+  void record(double d) {
+    unsigned long long ns = (unsigned long long)(d * 1e9);
+    int k = (ns == 0 ? 0 : 64 - __builtin_clzll(ns));
+    hist[k < NbH ? k : NbH - 1]++;
+  }
 public:
   /// Constructor
   stat_timer(int l=2): stat_base(l), nbr(0L), st(0), ct(0), dt(0), cumt(0) {
     DBGAFF_MEM("stat_timer::stat_timer", "Constructor()");
+    memset(hist, 0, sizeof(hist));
   }
   /// Constructor
   stat_timer(const stat_timer &stt): stat_base(stt), nbr(stt.nbr), st(stt.st), ct(stt.ct), dt(stt.dt), cumt(stt.cumt) {
     DBGAFF_MEM("stat_timer::stat_timer", "Const stat_timer");
+    memcpy(hist, stt.hist, sizeof(hist));
   }
   /// Constructor
   stat_timer(char s,const Id &id,int l=2): stat_base(s,id,l), nbr(0L), st(0), ct(0), dt(0), cumt(0) {
     DBGAFF_MEM("stat_timer::stat_timer", "Constructor(char *)");
+    memset(hist, 0, sizeof(hist));
   }
   /// Constructor
   stat_timer(char s,const Id &id, const char *_nst,int l=2): stat_base(s,id,_nst,l), nbr(0), st(0), ct(0), dt(0), cumt(0) {
     DBGAFF_MEM("stat_timer::stat_timer", "Constructor(char,char *)");
+    memset(hist, 0, sizeof(hist));
   }
   /// Destructor
   virtual ~stat_timer() {
@@ -177,18 +198,21 @@ public:
     set(_n, s,"",_log);
     nbr = 0L;
     st = ct = dt = cumt = 0.0;
+    memset(hist, 0, sizeof(hist));
   }
   /// Intialize the Statistics
   void init(char _n, const Id &s, const char *_nst,int _log=2) {
     set(_n, s,_nst,_log);
     nbr = 0;
     st = ct = dt = cumt = 0.0;
+    memset(hist, 0, sizeof(hist));
   }
   /** reset the statistics
     */
   void reset() { 
     nbr = 0;
     st = ct = dt = cumt = 0.0;
+    memset(hist, 0, sizeof(hist));
   }
   /// Set the start time
   virtual void start();
@@ -202,6 +226,15 @@ public:
     * @param id  the identifier of the related node
     */
   virtual void end(node_id id);
+  /** add a duration measured outside the start() and end() methods
+    * @param d the duration in seconds
+    */
+  void add_time(double d) {
+    nbr++;
+    dt = d;
+    cumt += d;
+    record(d);
+  }
   /** dump the stat
     * @param s the strbuff to fill
     */
@@ -216,6 +249,7 @@ public:
   void merge(const stat_timer &st) {
     nbr += st.nbr;
     cumt += st.cumt;
+    for (int k = 0; k < NbH; k++) hist[k] += st.hist[k];
   }
   /// gets the cumulating time
   double getc() const {
@@ -225,6 +259,16 @@ public:
   double getn() const {
     return nbr;
   }
+  /** gets the number of durations of a bucket of the histogram
+    * @param k the bucket
+    */
+  unsigned long long geth(int k) const {
+    return hist[k];
+  }
+  /** display the non empty buckets of the histogram
+    * @param os the ostream
+    */
+  void display_histo(ostream &os) const;
   /** Pack method to Serialize the stat_timer
     * @param bs the Serialize object
     */
@@ -236,6 +280,7 @@ public:
     bs.Pack(&ct, 1);
     bs.Pack(&dt, 1);
     bs.Pack(&cumt, 1);
+    bs.Pack(hist, NbH);
   }
   /** Unpack method to deserialize the stat_timer
     * @param bs the DeSerialize object
@@ -248,6 +293,7 @@ public:
     bs.UnPack(&ct, 1);
     bs.UnPack(&dt, 1);
     bs.UnPack(&cumt, 1);
+    bs.UnPack(hist, NbH);
   }
   /** Construct the log line header of the stat_timer.
     * Put the id, the name, and the type of the stat on a buffer
@@ -310,7 +356,7 @@ public:
   /** add a value to the counter
     * @param v the value to add
     */
-  void add(int v) {
+  void add(long long v) {
     nb += v;
     update_log();
   }
@@ -445,6 +491,8 @@ typedef std::map<char, stat_timer> MapTime;
  * A timer could be added with the add_timer method
  * get_timer and get_counter methods are used to get a counter 
  * or a timer according to the char passed by parameter.
+ * The counters and the timers are cached in arrays indexed by their char, 
+ * then the get_timer and get_counter methods do not search the maps.
  */
 class stat : public stat_base {
 protected:
@@ -452,15 +500,48 @@ protected:
   MapCount mc;
 /// the map that stores all the timers
   MapTime mt;
+/// the cache of the counters
+  stat_counter *cc[128];
+/// the cache of the timers
+  stat_timer *ct[128];
+/// empty the caches
+  void clear_cache() {
+    memset(cc, 0, sizeof(cc));
+    memset(ct, 0, sizeof(ct));
+  }
+/// fill the caches with the counters and the timers of the maps
+  void fill_cache() {
+    clear_cache();
+    for (MapCount::iterator i = mc.begin(); i != mc.end() ; i++) {
+      if ((unsigned char)i->first < 128) cc[(unsigned char)i->first] = &i->second;
+    }
+    for (MapTime::iterator i = mt.begin(); i != mt.end() ; i++) {
+      if ((unsigned char)i->first < 128) ct[(unsigned char)i->first] = &i->second;
+    }
+  }
     
 public:
   /// Constructor
   stat(): stat_base(), mc(), mt() {
     DBGAFF_MEM("stat::stat()", "Constructor");
+    clear_cache();
   }
   /// Constructor
   stat(const stat &st): stat_base(st), mc(st.mc), mt(st.mt) {
     DBGAFF_MEM("stat::stat(cons stat)", "Constructor");
+    fill_cache();
+  }
+  /** assignment operator
+    * @param st the stat to copy
+    */
+  stat &operator=(const stat &st) {
+    if (this != &st) {
+      stat_base::operator=(st);
+      mc = st.mc;
+      mt = st.mt;
+      fill_cache();
+    }
+    return *this;
   }
   /** Constructor
     * @param _n the identifier for this statitic
@@ -469,6 +550,7 @@ public:
     */
   stat(char _n, const Id &f,int l=2): stat_base(_n, f,l), mc(), mt() {
     DBGAFF_MEM("stat::stat(char *,Id &)", "Constructor");
+    clear_cache();
   }
   /** Constructor
     * @param _n the identifier for this statitic
@@ -478,6 +560,7 @@ public:
     */
   stat(char _n, const Id &f, const char *_nst,int l=2): stat_base(_n, f,_nst,l), mc(), mt() {
     DBGAFF_MEM("stat::stat(char *,Id &)", "Constructor");
+    clear_cache();
   }
   /// Destructor
   virtual ~stat() {
@@ -512,20 +595,40 @@ public:
     * @param l boolean the counter is logged or not.
     */
   void add_counter(char n, const char *nst, int l=2) {
-    mc[n].init(n, *this, nst, l);
+    get_counter(n).init(n, *this, nst, l);
   }
   /** add a value to the counter identified by n
     * @param n the identifier of the counter to modify
     * @param i the value to add to the counter
     */
   void add(char n, int i) {
-    mc[n].add(i);
+    get_counter(n).add(i);
   }
   /** obtain the counter identifed by the char n
     * @param n the identifier
     */
   stat_counter &get_counter(char n) {
-    return mc[n];
+    if ((unsigned char)n >= 128) return mc[n];
+    stat_counter *&c = cc[(unsigned char)n];
+    if (c == 0) {
+      stat_counter *nc = &mc[n];
+      // the counter is built before another thread could see it in the cache
+      __sync_synchronize();
+      c = nc;
+    }
+    return *c;
+  }
+  /** read the value of the counter identified by the char n without creating it.
+    * This method could be called by another thread than the one that updates 
+    * the counter, the value is then a snapshot. Only the cache is read, since
+    * the owner thread could insert a counter in the map at the same time.
+    * @param n the identifier
+    * @return the value of the counter (0 if the counter is not created yet)
+    */
+  unsigned long long peek_counter(char n) const {
+    if ((unsigned char)n >= 128) return 0;
+    const stat_counter *c = cc[(unsigned char)n];
+    return (c == 0 ? 0 : c->get());
   }
   //@}
   /** @name Timer
@@ -538,13 +641,30 @@ public:
     * @param l true if the timer is logged
     */
   void add_timer(char n, const char *nst,int l=2) {
-    mt[n].init(n, *this, nst,l);
+    get_timer(n).init(n, *this, nst,l);
   }
   /** obtain the timer identified by the char n
     * @param n the identifier
     */
   stat_timer &get_timer(char n) {
-    return mt[n];
+    if ((unsigned char)n >= 128) return mt[n];
+    stat_timer *&t = ct[(unsigned char)n];
+    if (t == 0) {
+      stat_timer *nt = &mt[n];
+      __sync_synchronize();
+      t = nt;
+    }
+    return *t;
+  }
+  /** read the number of runs of the timer identified by the char n without creating it.
+    * As for peek_counter(), this method could be called by another thread.
+    * @param n the identifier
+    * @return the number of runs of the timer (0 if the timer does not exist)
+    */
+  double peek_timer(char n) const {
+    if ((unsigned char)n >= 128) return 0;
+    const stat_timer *t = ct[(unsigned char)n];
+    return (t == 0 ? 0 : t->getn());
   }
   //@}
   /** Pack method to Serialize the SchedNode
@@ -578,6 +698,7 @@ public:
     display_title(os);
     display_label(os);
     display_data(os);
+    if (core::disp_histo()) display_histo(os);
   }
   /** method to display the title of the stat
     */
@@ -589,6 +710,9 @@ public:
   /** method to display the data of the stat.
     */
   void display_data(ostream &os,const char *lib="",int size=0);
+  /** method to display the histograms of the timers.
+    */
+  void display_histo(ostream &os);
   //@}
 };
 
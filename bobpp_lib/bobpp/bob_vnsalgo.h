@@ -317,6 +317,32 @@ public:
     if (sol == 0) return 0;
     return sol->getCost();
   }
+  /** Write the metrics of the goal and the cost of the incumbent (see the -- -mf option).
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) {
+    os << " sols=" << st.peek_counter('s') << " upd=" << st.peek_counter('u');
+    if (sol != 0) os << " inc=" << sol->getCost();
+  }
+  /** The search has no bound, nothing is written.
+    * @param os the std::ostream used to write the metrics
+    * @param bk the bound of the search as a key
+    */
+  virtual void MetricsBound(std::ostream &os, double bk) { }
+  /** The search has no pruning key, no node is pruned before the goal lock.
+    * @param n the node to test
+    */
+  virtual bool is_pruned(TheNode *n) { return false; }
+  /** The search has no pruning key.
+    */
+  virtual double inc_key() { return HUGE_VAL; }
+  /** The search has no pruning key, the remote key is ignored.
+    * @param k the key received from another process
+    */
+  virtual bool update_key(double k) { return false; }
+  /** The goal always holds its own best solution.
+    */
+  virtual bool holds_inc() { return true; }
   /** Intialize the Goal with the given instance.
     * @param ti the instance.
     * Mainly this method call the VNSInstance::getSol() method to get the incubent.
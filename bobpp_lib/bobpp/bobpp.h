@@ -576,6 +576,7 @@ namespace Bob {
 #include<bobpp/bob_core.h>
 #include<bobpp/bob_id.h>
 #include<bobpp/bob_stat.h>
+#include<bobpp/bob_nalloc.h>
 /**
  * @}
  */
@@ -7,19 +7,52 @@ namespace  Bob {
 namespace  mpx {
   int EnvProg::_nproc;
   int EnvProg::_rank;
+  bool EnvProg::_raw = false;
 
   void EnvProg::init(int &argc, char **&argv) {
+    core::opt().add(std::string("--mpx"), Property("-lm", "load metric of the load balancing (n=number of nodes, st=estimated subtree sizes)", "n"));
+    core::opt().add(std::string("--mpx"), Property("-raw", "raw binary encoding of the messages (homogeneous processes only)", &_raw));
     ThrEnvProg::init(1);
-    //MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED);
+    int provided;
+    // the communications are done by the strategy thread, not by the main thread
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &_nproc);
     MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    if (provided < MPI_THREAD_SERIALIZED) {
+      std::cerr << "MPx: the MPI library does not support the calls from a thread other than the main one"
+                << " (MPI_THREAD_SERIALIZED required, " << provided << " provided)" << std::endl;
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
     std::cout << "Init of node #" << _rank << " of " << _nproc << std::endl;
     core::log().setEId(new MPId());
   }
   void EnvProg::start() {
+    check_layout();
     ThrEnvProg::start();
   }
 
+  /** compare the data layouts of the processes, the raw encoding is kept
+    * only if all the processes ask for it and have the same byte order and
+    * the same sizes for the packed types.
+    */
+  void EnvProg::check_layout() {
+    const int one = 1;
+    int lay[9] = { _raw, *(const char *)&one, (int)sizeof(short), (int)sizeof(int),
+                   (int)sizeof(long), (int)sizeof(long long), (int)sizeof(float),
+                   (int)sizeof(double), (int)sizeof(void *) };
+    int lmin[9], lmax[9];
+    MPI_Allreduce(lay, lmin, 9, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(lay, lmax, 9, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (lmax[0] == 0) return;
+    _raw = (lmin[0] != 0);
+    for (int i = 1; i < 9; i++) {
+      if (lmin[i] != lmax[i]) _raw = false;
+    }
+    if (_rank == 0) {
+      std::cout << "MPx raw encoding " << (_raw ? "enabled" : "disabled, the processes differ") << std::endl;
+    }
+  }
+
   void EnvProg::end() {
     DBG_COMM("Call end ThrEnvProg\n");
     ThrEnvProg::end();
@@ -89,37 +122,5 @@ namespace  mpx {
    return rk.str();
 }*/
 
-void MPPackBuf::alloc(int size) {
-  //std::cout << "MPPackBuf::alloc(" << size << ")" << std::endl;
-  if (position + size <= buff_size)
-    return;
-  if (buff == 0)
-    buff_size = 4096;
-  while (position + size > buff_size)
-    buff_size *= 2;
-  buff = realloc(buff, buff_size);
-  if (buff == 0) {
-    perror("MPPackBuf::alloc");
-    exit(1);
-  }
-}
-
-void MPPackBuf::reset() {
-  position = 0;
-}
-
-MPPackBuf::MPPackBuf(int size): buff_size(size), position(0) {
-  buff = malloc(size);
-  if (buff == 0) {
-    perror("MPPackBuf::alloc");
-    exit(1);
-  }
-}
-
-MPPackBuf::~MPPackBuf() {
-  if(buff)
-    free(buff);
-}
-
 };
 };
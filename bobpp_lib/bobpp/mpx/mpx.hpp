@@ -3,11 +3,15 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <climits>
 #include <bobpp/bobpp>
 #include <bobpp/thr/thr.h>
 #include <math.h>
 
+#ifndef BOBPP_MPX_SHM
 #include <mpi.h>
+#endif
 #define BUFFER_SIZE 0x40000  /* 256 Ko */
 #define MAX_GRANULARITY 16
 
@@ -62,6 +66,22 @@ namespace Bob {
 @{
 \page MEPpage The message Passing programming Environment
 
+The messages are exchanged with one of two transports, chosen at compile time:
+- MPI (the default), the program is linked with libbobpp_mpi and launched with mpirun.
+- shared memory (the program is compiled with -DBOBPP_MPX_SHM and linked with libbobpp_shm),
+the processes run on a single host, they are forked by EnvProg::init() and the
+messages are copied in lock-free ring buffers of a POSIX shared memory segment,
+see the --shm options.
+
+With MPI, the data are packed with MPI_Pack() and sent as MPI_PACKED, which
+works on heterogeneous clusters. On a homogeneous cluster, the option
+--mpx -raw chooses a raw binary encoding: the data are copied with memcpy()
+in the buffer and the buffer is sent as MPI_BYTE. The data layouts of the
+processes (byte order and sizes of the types) are compared by EnvProg::start(),
+the raw encoding is disabled if they differ. The shared memory transport
+always uses the raw encoding.
+
+The strategies, the topologies and the environments are the same for the two transports.
 */
 
 
@@ -85,6 +105,10 @@ namespace mpx {
 class EnvProg {
   static int _nproc;
   static int _rank;
+#ifndef BOBPP_MPX_SHM
+  static bool _raw;
+  static void check_layout();
+#endif
 
 public:
   /// Constructor
@@ -103,9 +127,19 @@ public:
   static int nproc() {
     return _nproc;
   }
+#ifndef BOBPP_MPX_SHM
+  /// true if the raw binary encoding is used, see --mpx -raw
+  static bool raw() {
+    return _raw;
+  }
+  /// the MPI datatype of the buffers of the messages
+  static MPI_Datatype wire() {
+    return _raw ? MPI_BYTE : MPI_PACKED;
+  }
   /// Display the contents of a packed set of stuff
   static void DisplayPackedBuff(const void * buf, int count,
                                 MPI_Datatype datatype);
+#endif
 };
 
 
@@ -126,6 +160,60 @@ public:
 };
 
 
+/** the Class MPPackBuf
+ * this class implements a buffer for packed objects for the communications,
+ * it is used by the two transports.
+ */
+class MPPackBuf {
+public:
+  /// the buffer that stores the data
+  void * buff;
+  /// the size of buffer that stores the data
+  int buff_size;
+  /// the position of the end of the buffer.
+  int position;
+
+  /** Constructor
+    */
+  MPPackBuf(): buff(0), buff_size(0), position(0) {}
+  /** Constructor
+    * @param size the size of the internal buffer
+    */
+  MPPackBuf(int size): buff_size(size), position(0) {
+    buff = malloc(size);
+    if (buff == 0) {
+      perror("MPPackBuf::alloc");
+      exit(1);
+    }
+  }
+  /** Destructor
+    */
+  virtual ~MPPackBuf() {
+    if (buff)
+      free(buff);
+  }
+  /** method to perform the allocation of the internal buffer.
+    */
+  void alloc(int size) {
+    if (position + size <= buff_size)
+      return;
+    if (buff == 0)
+      buff_size = 4096;
+    while (position + size > buff_size)
+      buff_size *= 2;
+    buff = realloc(buff, buff_size);
+    if (buff == 0) {
+      perror("MPPackBuf::alloc");
+      exit(1);
+    }
+  }
+  /** method to reset the position
+    */
+  void reset() {
+    position = 0;
+  }
+};
+
 /** The solution data structure for the MP environment
  */
 template<class Trait>
@@ -233,7 +321,111 @@ public:
   }
 };
 
+/** The load metric of the load balancing strategies.
+  * The load of a process is the number of its open nodes, each node
+  * weighs 1 whatever its depth is.
+  * The metric is chosen with the --mpx -lm option, see MPPQ.
+  */
+class NodeLoad {
+public:
+  /// Destructor
+  virtual ~NodeLoad() {}
+  /// a node of depth d is inserted in the priority queue
+  virtual void ins(int d) {}
+  /// a node of depth d is deleted to be explored
+  virtual void explored(int d) {}
+  /// a node of depth d is deleted to be sent to another process
+  virtual void moved(int d) {}
+  /// nodes have been pruned, nb nodes remain in the priority queue
+  virtual void pruned(long nb) {}
+  /// the weight of a node of depth d
+  virtual long weight(int d) { return 1; }
+  /// the load of a priority queue which stores nb nodes
+  virtual long load(long nb) { return nb; }
+};
+
+/** The load metric of the estimated sizes of the subtrees.
+  * The weight of a node of depth d is the estimated size of its subtree,
+  * learned online from the nodes explored by the process with a TreeProfile
+  * (the estimator of the size of the tree, see the -- -mf option):
+  * S(d) = 1 + b(d)*r(d+1)*S(d+1), where b(d) is the number of nodes of depth
+  * d+1 inserted per explored node of depth d, r(d+1) the ratio of the
+  * inserted nodes of depth d+1 that are explored, and S(d)=1 for the deepest
+  * level. The pruned nodes are not counted in the profile (see below), r is
+  * then 1 for the levels with explored nodes.
+  * The load is the sum of the weights of the open nodes, hence a process
+  * which stores shallow nodes is more loaded than a process which stores
+  * the same number of nearly leaf nodes.
+  * The counters are updated without lock by the computing threads, the
+  * depths of the pruned nodes are unknown, the counters of the open nodes are
+  * then rescaled to the number of remaining nodes: the load is an estimate.
+  */
+class SubtreeLoad : public NodeLoad {
+  /// the number of depths, the deeper nodes are counted with the last depth
+  enum { MAX_DEPTH = TreeProfile::MAX_DEPTH };
+  /// the maximum estimated size of a subtree
+  static const long MAX_SIZE = 1000000000L;
+  /// the number of open nodes per depth
+  long nopen[MAX_DEPTH];
+  /// the profile of the nodes inserted and explored by the process, shared by the threads
+  TreeProfile prof;
+  /// the estimated sizes of the subtrees per depth
+  long est[MAX_DEPTH];
+  /// the depth d bounded by the number of depths
+  static int dep(int d) { return TreeProfile::dep(d); }
+  /// compute the estimated sizes of the subtrees from the deepest level
+  void estimate() {
+    double s[MAX_DEPTH];
+    prof.subtrees(s);
+    for (int d = prof.depth(); d >= 0; d--) {
+      est[d] = (s[d] > MAX_SIZE ? MAX_SIZE : (long)s[d]);
+    }
+  }
+public:
+  /// Constructor
+  SubtreeLoad() : prof(true) {
+    for (int d = 0; d < MAX_DEPTH; d++) {
+      nopen[d] = 0;
+      est[d] = 1;
+    }
+  }
+  /// Destructor
+  virtual ~SubtreeLoad() {}
+  virtual void ins(int d) {
+    __sync_add_and_fetch(&nopen[dep(d)], 1);
+    prof.child(d);
+  }
+  virtual void explored(int d) {
+    __sync_sub_and_fetch(&nopen[dep(d)], 1);
+    prof.explored(d);
+  }
+  virtual void moved(int d) {
+    __sync_sub_and_fetch(&nopen[dep(d)], 1);
+  }
+  virtual void pruned(long nb) {
+    long sum = 0;
+    int maxd = prof.depth();
+    for (int d = 0; d <= maxd; d++) sum += (nopen[d] > 0 ? nopen[d] : 0);
+    if (sum <= nb) return;
+    for (int d = 0; d <= maxd; d++) nopen[d] = (nopen[d] > 0 ? nopen[d] * nb / sum : 0);
+  }
+  virtual long weight(int d) { return est[dep(d)]; }
+  virtual long load(long nb) {
+    long l = 0;
+    if (nb <= 0) return 0;
+    estimate();
+    for (int d = 0; d <= prof.depth(); d++) {
+      if (nopen[d] > 0) l += nopen[d] * est[d];
+      if (l > LONG_MAX / 4) return LONG_MAX / 4;
+    }
+    // an open node weighs at least 1
+    return (l < nb ? nb : l);
+  }
+};
+
 /** Class to represent the priority queue use by several processors
+  * The load of the priority queue is given by a load metric, chosen with
+  * the --mpx -lm option (n=number of nodes, st=estimated subtree sizes).
  */
 template<class Trait,class TheSPQ>
 class MPPQ : public TheSPQ {
@@ -245,15 +437,18 @@ public:
   /// typedef to define the type of the priority.
   typedef typename Trait::Goal TheGoal;
 private:
+  /// the load metric
+  NodeLoad *metric;
 public:
 
   /// Constructor
   MPPQ(const Id &id, bool l) : TheSPQ(id,l) {
-    if (EnvProg::rank() != 0) {
-    }
+    if (core::opt().SVal("--mpx", "-lm") == "st") metric = new SubtreeLoad();
+    else metric = new NodeLoad();
   }
   /// Destructor
   virtual ~MPPQ() {
+    delete metric;
   }
   ///Reset method
   virtual void Reset() {
@@ -270,27 +465,48 @@ public:
   /// Insertion
   virtual void Ins(TheNode *n) {
     n->addRef();
+    metric->ins(n->dist());
     TheSPQ::Ins(n);
     //~ DBG_COMM("Insert Node "<<nbnode<<std::endl);
   }
+  /// Insertion of several nodes
+  virtual void InsBatch(TheNode **nds, int nb) {
+    for (int i = 0; i < nb; i++) {
+      nds[i]->addRef();
+      metric->ins(nds[i]->dist());
+    }
+    TheSPQ::InsBatch(nds, nb);
+  }
   /// Delete greater
   virtual int DelG(TheGoal &g) {
     int nb = TheSPQ::DelG(g);
+    if (nb > 0) metric->pruned(TheSPQ::nb_node());
     return nb;
   }
   virtual TheNode *Del() {
     TheNode *n =TheSPQ::Del();
     if ( n!=0 ) { 
        n->remRef();
+       metric->explored(n->dist());
     } 
     return n;
   }
+  /// Deletion of several nodes, the reference added by the insertion is removed from each node
+  virtual int DelBatch(TheNode **nds, int nb) {
+    int nbd = TheSPQ::DelBatch(nds, nb);
+    for (int i = 0; i < nbd; i++) {
+      nds[i]->remRef();
+      metric->explored(nds[i]->dist());
+    }
+    return nbd;
+  }
   /// Delete the best node
   virtual TheNode *DelLB() {
     DBG_COMM("AV nb_Node : "<<TheSPQ::nb_node()<<std::endl);
     TheNode *n = TheSPQ::DelLB();
     DBG_COMM("AP nb_Node : "<<TheSPQ::nb_node()<<std::endl);
     if ( n==0 && TheSPQ::nb_node()>0 ) DBG_COMM("argleuh DelLB gets null node but nb_Node : "<<TheSPQ::nb_node()<<std::endl);
+    if ( n!=0 ) metric->moved(n->dist());
     return n;
   }
   /// Prints the statistics and contents
@@ -299,7 +515,9 @@ public:
     return os;
   }
   /// return the load of the priority queue
-  long Load() { return TheSPQ::nb_node(); }
+  long Load() { return metric->load(TheSPQ::nb_node()); }
+  /// return the weight of a node in the load of the priority queue
+  long Weight(TheNode *n) { return metric->weight(n->dist()); }
 };
 
 } // End of namespace mpx
@@ -311,6 +529,10 @@ public:
 } // End of the namespace bobpp
 #endif
 
+#ifdef BOBPP_MPX_SHM
+#include <bobpp/mpx/mpx_shm.hpp>
+#else
 #include <bobpp/mpx/mpx_mess.hpp>
+#endif
 #include <bobpp/mpx/mpx_strategy.hpp>
 #include <bobpp/mpx/mpx_env.hpp>
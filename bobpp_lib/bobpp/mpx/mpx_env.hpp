@@ -68,7 +68,6 @@ private:
     * @param n the initial node
     */
   void send_init(TheInstance *inst, TheNode *n) {
-      int size;
       MPOut out;
       // Initialize the non-blocking receives
 
@@ -84,23 +83,18 @@ private:
 
       inst->Pack(out);
       mpgoal->Pack(out);
-      MPI_Pack_size(out.position, MPI_PACKED, out.comm, &size);
-      MPI_Bcast(&size, 1, MPI_INT, 0, out.comm);
-      MPI_Bcast(out.buff, size, MPI_PACKED, 0, out.comm);
+      out.bcast(0);
+      DBG_COMM("--------------------Master has sent instance and goal: "<<out.position);
       out.reset();
-      DBG_COMM("--------------------Master has sent instance and goal: "<<size);
   }
   /** receive the initial value of the instance and the goal.
     */
   void recv_init(TheInstance *inst) {
       MPIn in;
-      int size;
-      MPI_Bcast(&size, 1, MPI_INT, 0, in.comm);
-      in.alloc(size);
-      MPI_Bcast(in.buff, size, MPI_PACKED, 0, in.comm);
+      in.bcast(0);
       inst->UnPack(in);
       mpgoal->UnPack(in);
-      DBG_COMM("--------------------Slave has received instance and goal: "<<size);
+      DBG_COMM("--------------------Slave has received instance and goal: "<<in.position);
   }
   void notify_end_algo() {
       MPOut out;
@@ -200,7 +194,7 @@ public:
       for (int i=1;i<EnvProg::nproc();i++) {
         int nbst;
         DBG_COMM("Master waits for receiving stat "<<i<<"/"<<EnvProg::nproc());
-        in.recv(i,123);
+        in.recv(i,TAG_STAT);
         in.UnPack(&nbst,1);
         DBG_COMM("Master has received stats for "<< nbst<<" threads");
         for (int j=0;j<nbst;j++) {
@@ -218,7 +212,7 @@ public:
       MPOut out(BUFFER_SIZE);
       DBG_COMM("Slave sends its stats\n");
       TheThrAlgoEnvProg::Pack_Stat(out);
-      out.send(0,"Stat",123);
+      out.send(0,"Stat",TAG_STAT);
       DBG_COMM("Slave has sent its stats\n");
     }
   }
@@ -12,42 +12,12 @@ namespace mpx {
 @{
 */
 
-/** the Class MPPackBuf
- * this class implements a buffer for packed objects for MPI communication.
- */
-class MPPackBuf {
-public:
-  /// the buffer that stores the data
-  void * buff;
-  /// the size of buffer that stores the data
-  int buff_size;
-  /// the position of the end of the buffer.
-  int position;
-
-  /** Constructor
-    */
-  MPPackBuf(): buff(0), buff_size(0), position(0) {}
-  /** Constructor
-    * @param size the size of the internal buffer
-    */
-  MPPackBuf(int size);
-  /** Destructor
-    */
-  virtual ~MPPackBuf();
-  /** method to perform the allocation of the internal buffer.
-    */
-  void alloc(int size);
-  /** method to reset the position
-    */
-  void reset();
-};
-
-
-
 /** the Class MPOut
  * this class inherits from the Serialize class, this is a wrapper
  * to call the MP methods to pack datas but respecting the
  * Bob++ interface.
+ * With the raw encoding (see EnvProg::raw()), the data are copied in the
+ * buffer with memcpy() instead of MPI_Pack().
  * It also implements send operations
  */
 class MPOut : public Serialize, public MPPackBuf {
@@ -60,18 +30,21 @@ public:
   MPI_Status status;
   /// boolean to know if the stored message has been sent or not.
   bool sent;
+  /// boolean to know if a non-blocking send of the buffer is not completed.
+  bool pending;
   /** Constructor
     * @param _comm the MP communicator
     */
-  MPOut(MPI_Comm _comm = MPI_COMM_WORLD): comm(_comm), sent(false) {}
+  MPOut(MPI_Comm _comm = MPI_COMM_WORLD): comm(_comm), sent(false), pending(false) {}
   /** Constructor
     * @param size the size of the buffer.
     * @param _comm the MP communicator
     */
-  MPOut(int size, MPI_Comm _comm = MPI_COMM_WORLD): MPPackBuf(size), comm(_comm) {}
+  MPOut(int size, MPI_Comm _comm = MPI_COMM_WORLD): MPPackBuf(size), comm(_comm), sent(false), pending(false) {}
   /** Destructor
+    * the buffer could not be freed while it is sent.
     */
-  virtual ~MPOut() {}
+  virtual ~MPOut() { wait(); }
   /// Pack method for array of bool
   virtual int Pack(const bool *n, int nb = 1) {
     int i;
@@ -128,52 +101,88 @@ public:
   void send(int dest, const char *lib, int tag=0) {
     int r;
     DBG_COMM("----------------------------------------send to " << dest << " for :"<<lib<< " size:"<<position);
-    r = MPI_Send(buff, position, MPI_PACKED, dest, tag , comm);
+    r = MPI_Send(buff, position, EnvProg::wire(), dest, tag , comm);
     if ( r!=MPI_SUCCESS ) DBG_COMM("MPI_Send returns "<<r);
     sent = true;
   }
   /// Blocking send (standard mode)
   void send(int dest, int tag=0) {
     DBG_COMM("----------------------------------------send to " << dest );
-    MPI_Send(buff, position, MPI_PACKED, dest, tag , comm);
+    MPI_Send(buff, position, EnvProg::wire(), dest, tag , comm);
     sent = true;
   }
 
+  /** Non-blocking send (standard mode)
+    * the buffer must not be modified until the send is completed,
+    * see test() and wait().
+    */
+  void isend(int dest, const char *lib, int tag=0) {
+    DBG_COMM("----------------------------------------isend to " << dest << " for :"<<lib<< " size:"<<position);
+    MPI_Isend(buff, position, EnvProg::wire(), dest, tag, comm, &req);
+    sent = true;
+    pending = true;
+  }
   /// Non-blocking send (ready mode)
   void irsend(int dest) {
     DBG_COMM("init non-blocking send to " << dest);
     DBG_MEM("buffer size = " << position << " bytes");
-    MPI_Irsend(buff, position, MPI_PACKED, dest, 0, comm, &req);
+    MPI_Irsend(buff, position, EnvProg::wire(), dest, 0, comm, &req);
     sent = true;
+    pending = true;
   }
   /// Check if non-blocking send is complete
   bool test() {
+    if (!pending) return true;
     DBG_COMM("test send");
     int flag;
     MPI_Test(&req, &flag, &status);
     //DBG_ERR(status,"MPOut::test");
-    return flag != 0;
+    if (flag != 0) pending = false;
+    return !pending;
   }
   /// Wait for non-blocking send to finish
   void wait() {
+    if (!pending) return;
     DBG_COMM("wait send");
     MPI_Wait(&req, &status);
+    pending = false;
     //DBG_ERR(status,"MPOut::wait");
   }
+  /** Broadcast the message from the process root to all the processes,
+    * the other processes call MPIn::bcast().
+    * @param root the rank of the process which broadcasts the message
+    */
+  void bcast(int root=0) {
+    DBG_COMM("broadcast from " << root << " size:"<<position);
+    MPI_Bcast(&position, 1, MPI_INT, root, comm);
+    MPI_Bcast(buff, position, EnvProg::wire(), root, comm);
+  }
   /// Free allocated send request
   void free() {
     DBG_COMM("free send request");
     MPI_Request_free(&req);
   }
 private:
-  int _Pack(const void * buf, int count, MPI_Datatype datatype) {
+  /** pack count elements of type T, with MPI_Pack() or with memcpy() if the
+    * raw encoding is used.
+    */
+  template<class T>
+  int _Pack(const T * buf, int count, MPI_Datatype datatype) {
     int size;
     //std::cout<<"Pack ";
     //MPEnvProg::DisplayPackedBuff(buf,count,datatype);
     if (sent) {
+      wait();
       reset();
       sent = false;
     }
+    if (EnvProg::raw()) {
+      size = count * sizeof(T);
+      alloc(size);
+      memcpy((char *)buff + position, buf, size);
+      position += size;
+      return count;
+    }
     MPI_Pack_size(count, datatype, comm, &size);
     alloc(size);
     MPI_Pack((void*)buf, count, datatype, buff, buff_size, &position, comm);
@@ -186,6 +195,8 @@ private:
  * this class inherits from the DeSerialize class, this is a wrapper
  * to call the MP methods to unpack datas but respecting the
  * Bob++ interface.
+ * With the raw encoding (see EnvProg::raw()), the data are copied from the
+ * buffer with memcpy() instead of MPI_Unpack().
  * It also implements receive operations
  */
 class MPIn : public DeSerialize, public MPPackBuf {
@@ -268,10 +279,12 @@ public:
     DBG_COMM("----------------------------------------receive from " << source);
     MPI_Probe (source,tag,comm,&status);
     DBG_COMM(" probe from " << source);
-    MPI_Get_count( &status, MPI_PACKED, &count );
+    MPI_Get_count( &status, EnvProg::wire(), &count );
     DBG_COMM(" get count:"<<count<<" from " << source);
+    // the buffer is reused, it grows only if the message is larger
+    reset();
     alloc(count);
-    MPI_Recv(buff, count, MPI_PACKED, source, tag, comm, &status);
+    MPI_Recv(buff, count, EnvProg::wire(), source, tag, comm, &status);
     DBG_ERR(status, "MPIn::recv");
     reset();
   }
@@ -281,7 +294,7 @@ public:
     DBG_COMM("init NB receive from " << source);
     if (count == 0)
       count = buff_size;
-    MPI_Irecv(buff, count, MPI_PACKED, source, MPI_ANY_TAG, comm, &req);
+    MPI_Irecv(buff, count, EnvProg::wire(), source, MPI_ANY_TAG, comm, &req);
     reset();
   }
   /// Check if non-blocking receive is complete
@@ -304,11 +317,35 @@ public:
     //DBG_ERR(status,"MPIn::wait");
 #ifdef DEBUG_MEMORY
     int count;
-    MPI_Get_count(&status, MPI_PACKED, &count);
+    MPI_Get_count(&status, EnvProg::wire(), &count);
     DBG_MEM("size of received message = " << count << " bytes");
 #endif
     reset();
   }
+  /** Receive the message broadcast by the process root with MPOut::bcast()
+    * @param root the rank of the process which broadcasts the message
+    */
+  void bcast(int root=0) {
+    int size;
+    MPI_Bcast(&size, 1, MPI_INT, root, comm);
+    reset();
+    alloc(size);
+    MPI_Bcast(buff, size, EnvProg::wire(), root, comm);
+  }
+  /** Check for an incoming message without blocking
+    * @param source the rank of the sender of the message, if any
+    * @param tag the tag of the message, if any
+    * @return true if a message is arrived
+    */
+  bool iprobe(int &source, int &tag) {
+    int flag;
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &flag, &status);
+    if (flag) {
+      source = status.MPI_SOURCE;
+      tag = status.MPI_TAG;
+    }
+    return flag != 0;
+  }
   /// Check for incoming message
   int probe(int source = MPI_ANY_SOURCE) {
     DBG_COMM("probe");
@@ -319,7 +356,7 @@ public:
   /// Get number of received elements
   int count() {
     int count;
-    MPI_Get_count(&status, MPI_PACKED, &count);
+    MPI_Get_count(&status, EnvProg::wire(), &count);
     return count;
   }
   /// Cancel pending non-blocking receive
@@ -328,8 +365,18 @@ public:
     MPI_Cancel(&req);
   }
 private:
-  int _UnPack(void * buf, int count, MPI_Datatype datatype) {
+  /** unpack count elements of type T, with MPI_Unpack() or with memcpy()
+    * if the raw encoding is used.
+    */
+  template<class T>
+  int _UnPack(T * buf, int count, MPI_Datatype datatype) {
     int size;
+    if (EnvProg::raw()) {
+      size = count * sizeof(T);
+      memcpy(buf, (char *)buff + position, size);
+      position += size;
+      return count;
+    }
     MPI_Pack_size(count, datatype, comm, &size);
     alloc(size);
     MPI_Unpack(buff, buff_size, &position, buf, count, datatype, comm);
@@ -0,0 +1,286 @@
+
+#ifndef BOBPP_MPX_SHM
+#define BOBPP_MPX_SHM
+#endif
+#include<bobpp/mpx/mpx.hpp>
+#include<cstdlib>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<sys/wait.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sched.h>
+#include<signal.h>
+#ifdef __linux__
+#include<sys/prctl.h>
+#endif
+
+namespace  Bob {
+namespace  mpx {
+  int EnvProg::_nproc;
+  int EnvProg::_rank;
+
+  /// the pids of the forked processes, known by the process 0
+  static std::vector<pid_t> children;
+  /// the size in Kbytes of a ring
+  static int ring_kb;
+
+  /** search the value of the option o of the group grp before the
+    * parsing of the options by core::Config(), the segment is created
+    * before the fork of the processes.
+    */
+  static int arg_val(int argc, char **argv, const char *grp, const char *o, int def) {
+    std::string g = "--";
+    for (int i = 1; i < argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == '-') g = argv[i];
+      else if (g == grp && strcmp(argv[i], o) == 0 && i + 1 < argc) return atoi(argv[i + 1]);
+    }
+    return def;
+  }
+
+  void EnvProg::init(int &argc, char **&argv) {
+    core::opt().add(std::string("--mpx"), Property("-lm", "load metric of the load balancing (n=number of nodes, st=estimated subtree sizes)", "n"));
+    core::opt().add(std::string("--shm"), Property("-np", "number of processes of the shared memory environment", 1, &_nproc));
+    core::opt().add(std::string("--shm"), Property("-rs", "size in Kbytes of the ring buffer between two processes", BUFFER_SIZE / 1024, &ring_kb));
+    _nproc = arg_val(argc, argv, "--shm", "-np", 1);
+    ring_kb = arg_val(argc, argv, "--shm", "-rs", BUFFER_SIZE / 1024);
+    if (_nproc < 1 || ring_kb < 1) {
+      std::cerr << "--shm -np and -rs must be positive\n";
+      exit(1);
+    }
+    ShmSeg::create(_nproc, (unsigned long)ring_kb * 1024);
+    // the buffered outputs would be written by all the processes
+    std::cout.flush();
+    fflush(stdout);
+    _rank = 0;
+    for (int i = 1; i < _nproc; i++) {
+      pid_t p = fork();
+      if (p < 0) {
+        perror("EnvProg::init fork");
+        exit(1);
+      }
+      if (p == 0) {
+        _rank = i;
+        children.clear();
+#ifdef __linux__
+        // a process does not survive the process 0
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+        break;
+      }
+      children.push_back(p);
+    }
+    ThrEnvProg::init(1);
+    std::cout << "Init of node #" << _rank << " of " << _nproc << std::endl;
+    core::log().setEId(new MPId());
+  }
+  void EnvProg::start() {
+    ThrEnvProg::start();
+  }
+
+  void EnvProg::end() {
+    DBG_COMM("Call end ThrEnvProg\n");
+    ThrEnvProg::end();
+    for (unsigned int i = 0; i < children.size(); i++) {
+      int st;
+      if (waitpid(children[i], &st, 0) > 0 && !(WIFEXITED(st) && WEXITSTATUS(st) == 0)) {
+        std::cerr << "process #" << i + 1 << " has failed\n";
+      }
+    }
+    children.clear();
+    ShmSeg::destroy();
+    DBG_COMM("End of process");
+  }
+
+  char *ShmSeg::base = 0;
+  unsigned long ShmSeg::ring_size = 0;
+  unsigned long ShmSeg::ring_stride = 0;
+  unsigned long ShmSeg::seg_size = 0;
+  std::vector<std::deque<ShmSend> > ShmSeg::backlog;
+  std::vector<std::deque<ShmMsg> > ShmSeg::inbox;
+  int ShmSeg::next = 0;
+
+  void ShmSeg::create(int np, unsigned long rs) {
+    char name[64];
+    ring_size = rs;
+    ring_stride = (sizeof(ShmRing) + rs + SHM_LINE - 1) / SHM_LINE * SHM_LINE;
+    seg_size = np * np * ring_stride;
+    // the segment is unlinked as soon as it is mapped, the forked processes
+    // inherit the mapping and nothing is left if a process is killed.
+    sprintf(name, "/bobpp_shm.%d", (int)getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      perror("ShmSeg::create shm_open");
+      exit(1);
+    }
+    if (ftruncate(fd, seg_size) != 0) {
+      perror("ShmSeg::create ftruncate");
+      shm_unlink(name);
+      exit(1);
+    }
+    base = (char *)mmap(0, seg_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    shm_unlink(name);
+    close(fd);
+    if (base == MAP_FAILED) {
+      perror("ShmSeg::create mmap");
+      exit(1);
+    }
+    backlog.resize(np);
+    inbox.resize(np);
+  }
+
+  void ShmSeg::destroy() {
+    if (base == 0) return;
+    for (unsigned int i = 0; i < inbox.size(); i++) {
+      while (!inbox[i].empty()) {
+        free(inbox[i].front().buff);
+        inbox[i].pop_front();
+      }
+    }
+    munmap(base, seg_size);
+    base = 0;
+  }
+
+  void ShmSeg::put(ShmRing *r, unsigned long pos, const void *src, unsigned long n) {
+    unsigned long o = pos % ring_size;
+    unsigned long n1 = (n < ring_size - o ? n : ring_size - o);
+    memcpy(r->data() + o, src, n1);
+    if (n1 < n) memcpy(r->data(), (const char *)src + n1, n - n1);
+  }
+
+  void ShmSeg::get(ShmRing *r, unsigned long pos, void *dst, unsigned long n) {
+    unsigned long o = pos % ring_size;
+    unsigned long n1 = (n < ring_size - o ? n : ring_size - o);
+    memcpy(dst, r->data() + o, n1);
+    if (n1 < n) memcpy((char *)dst + n1, r->data(), n - n1);
+  }
+
+  void ShmSeg::post(int dest, int tag, MPOut *out) {
+    ShmSend s;
+    s.out = out;
+    s.tag = tag;
+    s.done = 0;
+    backlog[dest].push_back(s);
+    pump(dest);
+  }
+
+  bool ShmSeg::pump(int dest) {
+    ShmRing *r = ring(EnvProg::rank(), dest);
+    while (!backlog[dest].empty()) {
+      ShmSend &s = backlog[dest].front();
+      unsigned long h = r->head;
+      unsigned long t = r->tail;
+      // the bytes of the ring are not overwritten before they are read
+      __sync_synchronize();
+      unsigned long fr = ring_size - (h - t);
+      if (s.done == 0) {
+        ShmHeader hd;
+        if (fr < sizeof(ShmHeader)) return false;
+        hd.tag = s.tag;
+        hd.len = s.out->position;
+        put(r, h, &hd, sizeof(ShmHeader));
+        h += sizeof(ShmHeader);
+        fr -= sizeof(ShmHeader);
+        s.done = sizeof(ShmHeader);
+      }
+      unsigned long n = s.out->position + sizeof(ShmHeader) - s.done;
+      if (n > fr) n = fr;
+      put(r, h, (char *)s.out->buff + s.done - sizeof(ShmHeader), n);
+      s.done += n;
+      // the bytes are written before they are published
+      __sync_synchronize();
+      r->head = h + n;
+      if (s.done < s.out->position + (int)sizeof(ShmHeader)) return false;
+      s.out->pending = false;
+      backlog[dest].pop_front();
+    }
+    return true;
+  }
+
+  void ShmSeg::poll(int source) {
+    ShmRing *r = ring(source, EnvProg::rank());
+    unsigned long h = r->head;
+    unsigned long t = r->tail;
+    // the bytes are read after they are published
+    __sync_synchronize();
+    if (h == t) return;
+    std::deque<ShmMsg> &q = inbox[source];
+    while (h > t) {
+      if (q.empty() || q.back().done == q.back().len) {
+        ShmMsg m;
+        ShmHeader hd;
+        if (h - t < sizeof(ShmHeader)) break;
+        get(r, t, &hd, sizeof(ShmHeader));
+        t += sizeof(ShmHeader);
+        m.tag = hd.tag;
+        m.len = hd.len;
+        m.done = 0;
+        m.buff = malloc(hd.len > 16 ? hd.len : 16);
+        if (m.buff == 0) {
+          perror("ShmSeg::poll");
+          exit(1);
+        }
+        q.push_back(m);
+      }
+      ShmMsg &m = q.back();
+      unsigned long n = m.len - m.done;
+      if (n > h - t) n = h - t;
+      get(r, t, (char *)m.buff + m.done, n);
+      m.done += n;
+      t += n;
+    }
+    // the bytes are read before the source overwrites them
+    __sync_synchronize();
+    r->tail = t;
+  }
+
+  void ShmSeg::progress() {
+    for (int i = 0; i < EnvProg::nproc(); i++) {
+      if (!backlog[i].empty()) pump(i);
+      poll(i);
+    }
+  }
+
+  void ShmSeg::idle() {
+    sched_yield();
+  }
+
+  bool ShmSeg::iprobe(int &source, int &tag) {
+    int np = EnvProg::nproc();
+    progress();
+    for (int k = 0; k < np; k++) {
+      int i = (next + k) % np;
+      std::deque<ShmMsg> &q = inbox[i];
+      if (!q.empty() && q.front().done == q.front().len) {
+        source = i;
+        tag = q.front().tag;
+        next = (i + 1) % np;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void ShmSeg::recv(int source, int tag, MPIn &in) {
+    std::deque<ShmMsg> &q = inbox[source];
+    for (;;) {
+      progress();
+      for (std::deque<ShmMsg>::iterator it = q.begin(); it != q.end(); ++it) {
+        if (it->done < it->len) break;
+        if (tag != SHM_ANY_TAG && it->tag != tag) continue;
+        // the buffer of the message becomes the buffer of in
+        free(in.buff);
+        in.buff = it->buff;
+        in.buff_size = (it->len > 16 ? it->len : 16);
+        in.position = 0;
+        in.source = source;
+        in.tag = it->tag;
+        q.erase(it);
+        return;
+      }
+      idle();
+    }
+  }
+
+};
+};
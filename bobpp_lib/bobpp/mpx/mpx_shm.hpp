@@ -0,0 +1,332 @@
+#ifndef BOB_SHMMPXENVPROG
+#define BOB_SHMMPXENVPROG
+
+#include <string.h>
+
+namespace Bob {
+namespace mpx {
+
+/**
+@defgroup MPEnvProgShmGRP The shared memory transport
+@brief The transport of the Bobpp MPx programming environment over shared memory
+@ingroup MPEnvProgGRP
+@{
+This transport replaces MPI when all the processes run on the same host
+(the program is compiled with -DBOBPP_MPX_SHM and linked with libbobpp_shm).
+EnvProg::init() creates a POSIX shared memory segment with one ring buffer for each
+couple of processes (source, destination), then it forks the other processes.
+A message is a ShmHeader followed by the packed data, the data are copied
+in the ring of the destination with memcpy, a message larger than the free space of
+the ring is copied piece by piece while the destination reads it.
+The classes MPOut and MPIn have the same interface as the MPI ones, they
+are used by one thread at a time, like with MPI_THREAD_SERIALIZED.
+*/
+
+#define SHM_ANY_SOURCE -1 /* receive from any process */
+#define SHM_ANY_TAG -1 /* receive a message with any tag */
+#define SHM_TAG_BCAST -2 /* tag of the broadcast messages */
+#define SHM_LINE 64 /* size of a cache line, the indexes of a ring are on different lines */
+
+class MPOut;
+class MPIn;
+
+/** The header of a message in a ring
+  */
+struct ShmHeader {
+  /// the tag of the message
+  int tag;
+  /// the size in bytes of the data of the message
+  int len;
+};
+
+/** A lock-free ring buffer of the shared memory segment.
+  * The source is the only writer of head and the destination the only
+  * writer of tail, so the ring needs no lock and no atomic operation,
+  * only memory barriers. The data of the ring follow the structure.
+  */
+struct ShmRing {
+  /// the number of bytes written by the source since the beginning
+  volatile unsigned long head;
+  /// head and tail are not on the same cache line
+  char pad_head[SHM_LINE - sizeof(unsigned long)];
+  /// the number of bytes read by the destination since the beginning
+  volatile unsigned long tail;
+  /// the data are not on the cache line of tail
+  char pad_tail[SHM_LINE - sizeof(unsigned long)];
+  /// the data of the ring
+  char *data() { return (char *)(this + 1); }
+};
+
+/** A message sent with a non-blocking send, which is not completely
+  * copied in the ring of the destination.
+  */
+struct ShmSend {
+  /// the buffer of the message
+  MPOut *out;
+  /// the tag of the message
+  int tag;
+  /// the number of bytes of the message (header included) already in the ring
+  int done;
+};
+
+/** A message read from a ring, which is not yet received.
+  * The last message of a source could be incomplete.
+  */
+struct ShmMsg {
+  /// the tag of the message
+  int tag;
+  /// the size in bytes of the data
+  int len;
+  /// the number of bytes of the data already read
+  int done;
+  /// the data of the message
+  void *buff;
+};
+
+/** The shared memory segment of the processes and the messages in progress.
+  * The rings are read as soon as possible, a received message is stored in
+  * a private buffer which is given to the MPIn object, so a process never waits
+  * for a destination which is itself waiting.
+  */
+class ShmSeg {
+  /// the base address of the segment
+  static char *base;
+  /// the size in bytes of the data of a ring
+  static unsigned long ring_size;
+  /// the size in bytes of a ring in the segment
+  static unsigned long ring_stride;
+  /// the size in bytes of the segment
+  static unsigned long seg_size;
+  /// the messages in progress for each destination, in the order of the sends
+  static std::vector<std::deque<ShmSend> > backlog;
+  /// the messages read from each source, in the order of the sends
+  static std::vector<std::deque<ShmMsg> > inbox;
+  /// the next source to probe, the sources are probed in a round robin way
+  static int next;
+  /// copy n bytes in the ring at the position pos
+  static void put(ShmRing *r, unsigned long pos, const void *src, unsigned long n);
+  /// copy n bytes from the ring at the position pos
+  static void get(ShmRing *r, unsigned long pos, void *dst, unsigned long n);
+  /// copy the messages in progress for the destination dest in its ring
+  static bool pump(int dest);
+  /// read the available bytes of the ring of the source
+  static void poll(int source);
+public:
+  /** create the segment, called before the fork of the processes
+    * @param np the number of processes
+    * @param rs the size in bytes of a ring
+    */
+  static void create(int np, unsigned long rs);
+  /// unmap the segment
+  static void destroy();
+  /// get the ring from the process src to the process dst
+  static ShmRing *ring(int src, int dst) {
+    return (ShmRing *)(base + (src * EnvProg::nproc() + dst) * ring_stride);
+  }
+  /** start the send of a message, the out object is pending until all
+    * its bytes are in the ring of the destination.
+    * @param dest the rank of the destination
+    * @param tag the tag of the message
+    * @param out the message
+    */
+  static void post(int dest, int tag, MPOut *out);
+  /// copy the messages in progress and read the rings, never blocks
+  static void progress();
+  /// let the other processes work when a process waits for a message
+  static void idle();
+  /** Check for an incoming message without blocking
+    * @param source the rank of the sender of the message, if any
+    * @param tag the tag of the message, if any
+    * @return true if a complete message is arrived
+    */
+  static bool iprobe(int &source, int &tag);
+  /** Blocking receive, the buffer of in is replaced by the buffer of the message
+    * @param source the rank of the sender
+    * @param tag the tag of the message or SHM_ANY_TAG
+    * @param in the received message
+    */
+  static void recv(int source, int tag, MPIn &in);
+};
+
+/** the Class MPOut
+ * this class inherits from the Serialize class, the datas are
+ * copied in the buffer with memcpy, all the processes are on the same host.
+ * It also implements send operations
+ */
+class MPOut : public Serialize, public MPPackBuf {
+public:
+  /// boolean to know if the stored message has been sent or not.
+  bool sent;
+  /// boolean to know if a non-blocking send of the buffer is not completed.
+  bool pending;
+  /** Constructor
+    */
+  MPOut(): sent(false), pending(false) {}
+  /** Constructor
+    * @param size the size of the buffer.
+    */
+  MPOut(int size): MPPackBuf(size), sent(false), pending(false) {}
+  /** Destructor
+    * the buffer could not be freed while it is sent.
+    */
+  virtual ~MPOut() { wait(); }
+  /// Pack method for array of bool
+  virtual int Pack(const bool *n, int nb = 1) { return _Pack(n, nb, sizeof(bool)); }
+  /// Pack method for array of int
+  virtual int Pack(const int *n, int nb = 1) { return _Pack(n, nb, sizeof(int)); }
+  /// Pack method for array of unsigned int
+  virtual int Pack(const unsigned int *n, int nb = 1) { return _Pack(n, nb, sizeof(unsigned int)); }
+  /// Pack method for array of short
+  virtual int Pack(const short *n, int nb = 1) { return _Pack(n, nb, sizeof(short)); }
+  /// Pack method for array of unsigned short
+  virtual int Pack(const unsigned short *n, int nb = 1) { return _Pack(n, nb, sizeof(unsigned short)); }
+  /// Pack method for array of long long
+  virtual int Pack(const long long *n, int nb = 1) { return _Pack(n, nb, sizeof(long long)); }
+  /// Pack method for array of unsigned long long
+  virtual int Pack(const unsigned long long *n, int nb = 1) { return _Pack(n, nb, sizeof(unsigned long long)); }
+  /// Pack method for array of long
+  virtual int Pack(const long *n, int nb = 1) { return _Pack(n, nb, sizeof(long)); }
+  /// Pack method for array of unsigned long
+  virtual int Pack(const unsigned long *n, int nb = 1) { return _Pack(n, nb, sizeof(unsigned long)); }
+  /// Pack method for array of float
+  virtual int Pack(const float *n, int nb = 1) { return _Pack(n, nb, sizeof(float)); }
+  /// Pack method for array of double
+  virtual int Pack(const double *n, int nb = 1) { return _Pack(n, nb, sizeof(double)); }
+  /// Pack method for array of char
+  virtual int Pack(const char *s, int nb = 1) { return _Pack(s, nb, sizeof(char)); }
+  /// Blocking send
+  void send(int dest, const char *lib, int tag=0) {
+    isend(dest, lib, tag);
+    wait();
+  }
+  /// Blocking send
+  void send(int dest, int tag=0) { send(dest, "", tag); }
+  /** Non-blocking send
+    * the buffer must not be modified until the send is completed,
+    * see test() and wait().
+    */
+  void isend(int dest, const char *lib, int tag=0) {
+    DBG_COMM("----------------------------------------isend to " << dest << " for :"<<lib<< " size:"<<position);
+    sent = true;
+    pending = true;
+    ShmSeg::post(dest, tag, this);
+  }
+  /// Check if non-blocking send is complete
+  bool test() {
+    if (pending) ShmSeg::progress();
+    return !pending;
+  }
+  /// Wait for non-blocking send to finish
+  void wait() {
+    while (pending) {
+      ShmSeg::progress();
+      if (pending) ShmSeg::idle();
+    }
+  }
+  /** Broadcast the message from the process root to all the processes,
+    * the other processes call MPIn::bcast().
+    * @param root the rank of the process which broadcasts the message
+    */
+  void bcast(int root=0) {
+    for (int i = 0; i < EnvProg::nproc(); i++) {
+      if (i != root) send(i, "bcast", SHM_TAG_BCAST);
+    }
+  }
+private:
+  int _Pack(const void * buf, int count, int size) {
+    if (sent) {
+      wait();
+      reset();
+      sent = false;
+    }
+    alloc(count * size);
+    memcpy((char *)buff + position, buf, count * size);
+    position += count * size;
+    return count;
+  }
+};
+
+
+/** The Class MPIn
+ * this class inherits from the DeSerialize class, the datas are
+ * copied from the buffer with memcpy.
+ * It also implements receive operations
+ */
+class MPIn : public DeSerialize, public MPPackBuf {
+public:
+  /// the rank of the sender of the last received message
+  int source;
+  /// the tag of the last received message
+  int tag;
+  /** Constructor
+    */
+  MPIn(): source(SHM_ANY_SOURCE), tag(SHM_ANY_TAG) {}
+  /** Constructor
+    * @param size the size of the buffer.
+    */
+  MPIn(int size): MPPackBuf(size), source(SHM_ANY_SOURCE), tag(SHM_ANY_TAG) {}
+  /** Destructor
+    */
+  virtual ~MPIn() {}
+  /// UnPack method for array of bool
+  virtual void UnPack(bool *n, int nb = 1) { _UnPack(n, nb, sizeof(bool)); }
+  /// UnPack method for array of int
+  virtual void UnPack(int *n, int nb = 1) { _UnPack(n, nb, sizeof(int)); }
+  /// UnPack method for array of unsigned int
+  virtual void UnPack(unsigned int *n, int nb = 1) { _UnPack(n, nb, sizeof(unsigned int)); }
+  /// UnPack method for array of short
+  virtual void UnPack(short *n, int nb = 1) { _UnPack(n, nb, sizeof(short)); }
+  /// UnPack method for array of unsigned short
+  virtual void UnPack(unsigned short *n, int nb = 1) { _UnPack(n, nb, sizeof(unsigned short)); }
+  /// UnPack method for array of long long
+  virtual void UnPack(long long *n, int nb = 1) { _UnPack(n, nb, sizeof(long long)); }
+  /// UnPack method for array of unsigned long long
+  virtual void UnPack(unsigned long long *n, int nb = 1) { _UnPack(n, nb, sizeof(unsigned long long)); }
+  /// UnPack method for array of long
+  virtual void UnPack(long *n, int nb = 1) { _UnPack(n, nb, sizeof(long)); }
+  /// UnPack method for array of unsigned long
+  virtual void UnPack(unsigned long *n, int nb = 1) { _UnPack(n, nb, sizeof(unsigned long)); }
+  /// UnPack method for array of float
+  virtual void UnPack(float *n, int nb = 1) { _UnPack(n, nb, sizeof(float)); }
+  /// UnPack method for array of double
+  virtual void UnPack(double *n, int nb = 1) { _UnPack(n, nb, sizeof(double)); }
+  /// UnPack method for array of char
+  virtual void UnPack(char *s, int nb = 1) { _UnPack(s, nb, sizeof(char)); }
+  /// Blocking receive
+  void recv(int source, int tag=SHM_ANY_TAG, int count = 0) {
+    DBG_COMM("----------------------------------------receive from " << source);
+    ShmSeg::recv(source, tag, *this);
+    reset();
+  }
+  /** Receive the message broadcast by the process root with MPOut::bcast()
+    * @param root the rank of the process which broadcasts the message
+    */
+  void bcast(int root=0) { recv(root, SHM_TAG_BCAST); }
+  /** Check for an incoming message without blocking
+    * @param source the rank of the sender of the message, if any
+    * @param tag the tag of the message, if any
+    * @return true if a message is arrived
+    */
+  bool iprobe(int &source, int &tag) { return ShmSeg::iprobe(source, tag); }
+  /// Check for incoming message
+  int probe(int source = SHM_ANY_SOURCE) {
+    int s, t;
+    DBG_COMM("probe");
+    while (!iprobe(s, t) || (source != SHM_ANY_SOURCE && s != source)) ShmSeg::idle();
+    return s;
+  }
+private:
+  int _UnPack(void * buf, int count, int size) {
+    memcpy(buf, (char *)buff + position, count * size);
+    position += count * size;
+    return count;
+  }
+};
+
+/** @}
+ */
+
+};
+};
+
+#endif
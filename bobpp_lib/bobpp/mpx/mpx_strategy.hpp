@@ -12,7 +12,8 @@ namespace mpx {
   * The aim of this module is to define all the class usefull to define the parallelization strategy. 
   * We would like to define different topology of communication, hierachical, collegial. 
   * And also different load balancing strategies.
-  * At this time we developp only the collegial topology, with a bi-threshold load balancing strategy
+  * At this time we developp only collegial topologies (ring, all2all, tree, hypercube), with a bi-threshold load balancing strategy
+  * and a randomized work stealing strategy
   */
 
 // Tags
@@ -23,11 +24,17 @@ namespace mpx {
 #define TAG_NOWORK 4 /* no_work message */
 #define TAG_GOAL 5 /* goal message */
 #define TAG_END 6 /* end message */
+#define TAG_SOL 7 /* solution message, sent to the main process after the end */
+#define TAG_STAT 123 /* statistics message, sent to the main process after the end */
 #define TAG_OTHER 100 /* no meaning message */
 
 // Headers
 #define HEADER_NODE 1 /* indicates a node */
 #define HEADER_FINISH 0 /* finish a message */
+#define HEADER_CHUNK 2 /* finish a chunk of a message, the next chunks follow */
+
+// size in bytes over which a work message is split in chunks
+#define WORK_CHUNK BUFFER_SIZE
 
 // token
 #define TOKEN_NOBODY -1 /* nobody wants to end the algorithm */
@@ -40,6 +47,12 @@ namespace mpx {
 #define MULTIPLY_SLEEP 2 /* the multiplicator for the time */
 #define REPEAT_SLEEP 4 /* the maximum number of time the sleeping time is not changed */
 
+// topology
+#define TREE_ARITY 2 /* number of children of a process in the tree topology */
+
+// incumbent management
+#define INC_WINDOW 0.001 /* time in seconds during which the improvements of the incumbent are coalesced */
+
 // load management
 #define LOAD_MIN 0.2 /* percentage under the average load a processor is considered as underloaded */
 #define LOAD_MAX 0.2 /* percentage over the average load a processor is considered as overloaded */
@@ -74,10 +87,11 @@ public:
 	int mode; /**< the mode of the token: LOAD or END */
 	int nb_nodes_in; /**< number of nodes that have been received by message */
 	int nb_nodes_out; /**< number of nodes that have been sent by message */
+	int dirty; /**< a process has received nodes since the previous end token */
 	pvector<long> load; /**< Load for each processor */
 
 	/// Constructors
-	Token(int size) : starter(TOKEN_NOBODY), mode(TOKEN_MODE_LOAD), nb_nodes_in(0), nb_nodes_out(0), load(size,0) {}
+	Token(int size) : starter(TOKEN_NOBODY), mode(TOKEN_MODE_LOAD), nb_nodes_in(0), nb_nodes_out(0), dirty(0), load(size,0) {}
 	/// Destructor
 	virtual ~Token() {}
 
@@ -88,12 +102,20 @@ public:
 	/// get the mode
 	virtual int get_mode() { return mode; }
 
-	/// set the number of messages
-	virtual void update_stats(int _in, int _out) { nb_nodes_in += _in; nb_nodes_out += _out; }
+	/** set the number of messages
+	* @param _in the number of nodes received by the process
+	* @param _out the number of nodes sent by the process
+	* @param _dirty the process has received nodes since the previous end token
+	*/
+	virtual void update_stats(int _in, int _out, bool _dirty=false) { nb_nodes_in += _in; nb_nodes_out += _out; dirty |= _dirty; }
 	/// reset the number of messages
-	virtual void reset_stats() { nb_nodes_in = 0; nb_nodes_out = 0; starter = EnvProg::rank(); }
-	/// test if the number of incoming messages is equal to the number of outgoing messages 
-	virtual bool verify_stats() { return (nb_nodes_in == nb_nodes_out); }
+	virtual void reset_stats() { nb_nodes_in = 0; nb_nodes_out = 0; dirty = 0; starter = EnvProg::rank(); }
+	/** test if the number of incoming messages is equal to the number of outgoing messages,
+	* and if no process has received nodes during the turn, otherwise a process
+	* visited before could have received nodes sent after the visit, and sent others
+	* to a process visited after, with balanced numbers of messages.
+	*/
+	virtual bool verify_stats() { return (nb_nodes_in == nb_nodes_out) && !dirty; }
 
 	/// neighbour: token is always used on a ring
 	virtual int neighbour() { return ((EnvProg::rank() + 1) % EnvProg::nproc()); }
@@ -101,6 +123,13 @@ public:
 
 /** TypeOut Structure
   * TypeOut structure facilitates the send MPI operation.
+  * The messages are sent with non-blocking sends: a message is packed
+  * in the current buffer, then this buffer is sent and the next message
+  * is packed in a spare buffer while the send is in progress.
+  * Two buffers are enough while the sends are completed at the pace of
+  * the messages, a new buffer is allocated instead of waiting when all
+  * the buffers are in progress, so a send could never block the
+  * strategy thread.
   */
 template<class Trait,class Load>
 struct TypedOut {
@@ -110,40 +139,82 @@ struct TypedOut {
 	typedef typename Trait::Stat TheStat;
 	/// Type of the Goal
 	typedef MPGoal<Trait> TheMPGoal;
-	/// The out object allows the unpack of the Bobpp types
-	MPOut out;
+	/// The out object allows the unpack of the Bobpp types, it is never in progress
+	MPOut *out;
+	/// The buffers whose send is in progress, in the order of the sends
+	std::deque<MPOut *> inflight;
+	/// The buffers ready to be reused
+	std::vector<MPOut *> spare;
 	/// Constructor
-	TypedOut() : out() {}
+	TypedOut() : out(new MPOut()), inflight(), spare(1, new MPOut()) {}
 	/// Destructor
-	virtual ~TypedOut() {}
+	virtual ~TypedOut() {
+		flush();
+		delete out;
+		for (unsigned int i=0 ; i<spare.size() ; i++) delete spare[i];
+	}
 	/** Reset method
 	* flush the out variable, and assign 0 to the type
 	*/
-	virtual void reset() { out.reset(); }
+	virtual void reset() { out->reset(); }
+	/// the size in bytes of the packed message
+	int size() { return out->position; }
 	/// pack the load
-	virtual void pack_load(Load *l) { Pack(out,l); }
+	virtual void pack_load(Load *l) { Pack(*out,l); }
 	/// pack a given node
 	virtual void pack_node(TheNode *n) {
 		int header = HEADER_NODE;
-		out.Pack(&header,1);
-		n->Pack(out);
+		out->Pack(&header,1);
+		n->Pack(*out);
 	}
 	/// pack the token 
 	virtual void pack_token(Token token) {
-		out.Pack(&token.starter,1);
-		out.Pack(&token.mode,1);
-		out.Pack(&token.nb_nodes_in,1);
-		out.Pack(&token.nb_nodes_out,1);
-		token.load.Pack(out);
+		out->Pack(&token.starter,1);
+		out->Pack(&token.mode,1);
+		out->Pack(&token.nb_nodes_in,1);
+		out->Pack(&token.nb_nodes_out,1);
+		out->Pack(&token.dirty,1);
+		token.load.Pack(*out);
 	}
 	/// pack the incubent
-	virtual void pack_incubent(TheMPGoal *g) { g->Pack(out); }
+	virtual void pack_incubent(TheMPGoal *g) { g->Pack(*out); }
+	/// pack the key of the incubent
+	virtual void pack_key(double k) { out->Pack(&k,1); }
+	/// pack a header
+	virtual void pack_header(int header) { out->Pack(&header,1); }
+	/// pack the end of a chunk of message
+	virtual void pack_chunk() { int header = HEADER_CHUNK; out->Pack(&header,1); }
 	/// pack the end message
-	virtual void pack_finish() { int header = HEADER_FINISH; out.Pack(&header,1); }
+	virtual void pack_finish() { int header = HEADER_FINISH; out->Pack(&header,1); }
 	/// send the message with a string to debug
-	virtual void send(int d, const char *lib, int tag=TAG_OTHER) { out.send(d, lib, tag); }
+	virtual void send(int d, const char *lib, int tag=TAG_OTHER) {
+		out->isend(d, lib, tag);
+		inflight.push_back(out);
+		progress();
+		if ( spare.empty() ) { out = new MPOut(); }
+		else { out = spare.back(); spare.pop_back(); }
+		out->reset();
+	}
 	/// send the message
-	virtual void send(int d, int tag=TAG_OTHER) { out.send(d, tag); }
+	virtual void send(int d, int tag=TAG_OTHER) { send(d, "", tag); }
+	/** test the completion of the sends in progress, the completed buffers are reused
+	* @return true if no send is in progress
+	*/
+	bool progress() {
+		while ( !inflight.empty() && inflight.front()->test() ) {
+			spare.push_back(inflight.front());
+			inflight.pop_front();
+		}
+		return inflight.empty();
+	}
+	/// wait for the completion of all the sends in progress
+	void flush() {
+		while ( !inflight.empty() ) {
+			inflight.front()->wait();
+			spare.push_back(inflight.front());
+			inflight.pop_front();
+		}
+	}
 };
 
 /** TypeIn Structure
@@ -179,12 +250,24 @@ struct TypedIn {
 		in.UnPack(&token.mode,1);
 		in.UnPack(&token.nb_nodes_in,1);
 		in.UnPack(&token.nb_nodes_out,1);
+		in.UnPack(&token.dirty,1);
 		token.load.UnPack(in);
 	}
 	/// unpack the incubent
 	virtual void unpack_incubent(TheMPGoal *g) { g->UnPack(in); }
+	/// unpack the key of the incubent
+	virtual double unpack_key() {
+		double k;
+		in.UnPack(&k,1);
+		return k;
+	}
 	/// test if a message is arrived
 	int probe() { return in.probe(); }
+	/** test if a message is arrived without blocking
+	* @param source the rank of the sender of the message, if any
+	* @param tag the tag of the message, if any
+	*/
+	bool iprobe(int &source, int &tag) { return in.iprobe(source, tag); }
 	/// receive a message
 	virtual void recv(int d, int tag=TAG_OTHER) { in.recv(d, tag); }
 };
@@ -199,8 +282,9 @@ struct TypedIn {
   * The unique and best topology, which outperforms all the other for all branch and bound
   * behaviour does not exist.
   * This module proposes different topologies to use with load blancing strategies.
-  * At this time we have all2all, ring. We plan to implement a hierarchical topology 
-  * like trees.
+  * At this time we have all2all, ring, tree and hypercube.
+  * The load, the work and the key of the goal are exchanged between neighbours, the token,
+  * the solution and the end messages are exchanged between any processes.
   */
 
 /** Abstract topology class is the base to define the different topologies we want.
@@ -213,9 +297,9 @@ public:
 	topology() : token(EnvProg::nproc()) { }
 	/// Destructor
 	virtual ~topology() { }
-	/// give the id of the process from its neighbour index
+	/// give the neighbour index from the id of the process, -1 if the process is not a neighbour
 	virtual int rank2neighbour(int i)=0;
-	/// give the id of the neighbour from its process id
+	/// give the id of the process from its neighbour index
 	virtual int neighbour2rank(int i)=0;
 	/// return the number of neighbours for this topology
 	virtual int nb_neighbour()=0;
@@ -243,10 +327,14 @@ public:
 	virtual ~topo_ring() { }
 	/// in a ring topology all processes have the same level of decision
 	virtual int is_collegial() { return true; }
-	/// give the neighbour from the rank
-	virtual int rank2neighbour(int i) { return ((EnvProg::rank()+EnvProg::nproc()-1+2*i)%EnvProg::nproc()); }
+	/// give the neighbour index from the rank, the previous process is 0, the next one is 1
+	virtual int rank2neighbour(int i) {
+		if ( i==neighbour2rank(0) ) return 0;
+		if ( i==neighbour2rank(1) ) return 1;
+		return -1;
+	}
 	/// give the rank from the neighbour index
-	virtual int neighbour2rank(int i) { return ((EnvProg::rank()-1+2*i)); }
+	virtual int neighbour2rank(int i) { return ((EnvProg::rank()+EnvProg::nproc()-1+2*i)%EnvProg::nproc()); }
 	/// return always 2
 	virtual int nb_neighbour() { return 2; }
 	/// return -1 there is no master
@@ -277,6 +365,69 @@ public:
 	virtual int main_rank() { return 0; }
 };
 
+/** define a topology given by the list of the neighbours of the process
+  */
+class topo_list : public topology {
+protected:
+	/// the ranks of the neighbours
+	std::vector<int> nb;
+public:
+	/// Constructor
+	topo_list(): topology(), nb() { }
+	/// Destructor
+	virtual ~topo_list() { }
+	/// return always true
+	virtual int is_collegial() { return true; }
+	/// search the rank in the list
+	virtual int rank2neighbour(int i) {
+		for (unsigned int j=0 ; j<nb.size() ; j++) if ( nb[j]==i ) return j;
+		return -1;
+	}
+	/// simple translation
+	virtual int neighbour2rank(int i) { return nb[i]; }
+	/// return the size of the list
+	virtual int nb_neighbour() { return nb.size(); }
+	/// return -1 there is no master
+	virtual int master() { return -1; }
+	/// return the main rank
+	virtual int main_rank() { return 0; }
+};
+
+/** define a tree topology
+  * the process i is the father of the processes TREE_ARITY*i+1 to TREE_ARITY*i+TREE_ARITY,
+  * the work goes down from the root through O(log(P)) hops.
+  */
+class topo_tree : public topo_list {
+public:
+	/// Constructor
+	topo_tree(): topo_list() {
+		int r = EnvProg::rank();
+		if ( r>0 ) nb.push_back((r-1)/TREE_ARITY);
+		for (int i=TREE_ARITY*r+1 ; i<=TREE_ARITY*r+TREE_ARITY && i<EnvProg::nproc() ; i++) nb.push_back(i);
+	}
+	/// Destructor
+	virtual ~topo_tree() { }
+	/// the root is the main process
+	virtual int main_rank() { return 0; }
+};
+
+/** define a hypercube topology
+  * the neighbours of the process i are the processes whose rank differs from i by one bit,
+  * when the number of processes is not a power of 2, the missing processes are skipped.
+  */
+class topo_hypercube : public topo_list {
+public:
+	/// Constructor
+	topo_hypercube(): topo_list() {
+		int r = EnvProg::rank();
+		for (int b=1 ; b<EnvProg::nproc() ; b<<=1) {
+			if ( (r^b)<EnvProg::nproc() ) nb.push_back(r^b);
+		}
+	}
+	/// Destructor
+	virtual ~topo_hypercube() { }
+};
+
 /**
   * @defgroup MPLoadEnvProgGRP The load balancing strategy
   * @brief The different classes to define the load balancing strategy
@@ -299,19 +450,23 @@ protected:
 	Topo topo; /**< the topology */
 	std::vector<TypedIn<Trait,Load> > in; /**< the vector of message to receive */
 	std::vector<TypedOut<Trait,Load> > out; /**< the vector of message to send */
+	TypedIn<Trait,Load> gin; /**< the message to receive from any process (token, solution, end) */
+	TypedOut<Trait,Load> gout; /**< the message to send to any process (token, solution, end) */
 	std::vector<Load> load; /**< vector of load of the other process */
 	std::vector<bool> asking; /**< vector to indicate if nodes are asked to this neighbour */
 	PQ *pq; /**< the priority queue used by the algorithms */
 	Goal *goal; /**< the Goal used by the algorithms */
+	double inc_sent; /**< the key of the incubent known by the neighbours */
+	double inc_time; /**< the time of the last sending of the key of the incubent */
 
 public:
 	/// Constructor
-	lb_strat() : topo(), in(topo.nb_neighbour()), out(topo.nb_neighbour()), load(topo.nb_neighbour()+1), asking(topo.nb_neighbour(),false), pq(0), goal(0) { }
+	lb_strat() : topo(), in(topo.nb_neighbour()), out(topo.nb_neighbour()), gin(), gout(), load(topo.nb_neighbour()+1), asking(topo.nb_neighbour(),false), pq(0), goal(0), inc_sent(HUGE_VAL), inc_time(0) { }
 	/** Constructor
 	* @param _pq the priority queue used
 	* @param _goal the Goal used 
 	*/
-	lb_strat(PQ *_pq, Goal *_goal) : topo(), in(topo.nb_neighbour()), out(topo.nb_neighbour()), load(topo.nb_neighbour()+1), asking(topo.nb_neighbour(),false), pq(_pq), goal(_goal) { }
+	lb_strat(PQ *_pq, Goal *_goal) : topo(), in(topo.nb_neighbour()), out(topo.nb_neighbour()), gin(), gout(), load(topo.nb_neighbour()+1), asking(topo.nb_neighbour(),false), pq(_pq), goal(_goal), inc_sent(HUGE_VAL), inc_time(0) { }
 	/// Destructor
 	virtual ~lb_strat() { }
 	/// operator launched by the main thread to perform the load balancing strategy
@@ -331,18 +486,16 @@ public:
 	/// Send the token
 	virtual void send_token() {
 		int rank = topo.token.neighbour();
-		int neighbour = topo.rank2neighbour(rank);
 		DBG_COMM("sends TOKEN to " << rank);
-		out[neighbour].reset();
-		out[neighbour].pack_token(topo.token);
-		out[neighbour].send(rank, "token", TAG_TOKEN);
+		gout.reset();
+		gout.pack_token(topo.token);
+		gout.send(rank, "token", TAG_TOKEN);
 	}
 	/// Receive the token
 	virtual void receive_token(int rank) {
-		int neighbour = topo.rank2neighbour(rank);
 		DBG_COMM("receives TOKEN from " << rank);
-		in[neighbour].recv(rank, TAG_TOKEN);
-		in[neighbour].unpack_token(topo.token);
+		gin.recv(rank, TAG_TOKEN);
+		gin.unpack_token(topo.token);
 	}
 
 	/** LOAD **/
@@ -351,7 +504,8 @@ public:
 		long end_detection = 0;
 		for (int i=0 ; i < (int) topo.token.load.size() ; i++ ) {
 			if (i != EnvProg::rank()) {
-				load[topo.rank2neighbour(i)] = topo.token.load[i];
+				int neighbour = topo.rank2neighbour(i);
+				if ( neighbour>=0 ) load[neighbour] = topo.token.load[i];
 				end_detection += topo.token.load[i];
 			}
 		}
@@ -401,27 +555,52 @@ public:
 		unpack_load(neighbour);
 	}
 
+	/** SEND **/
+	/// Test the completion of the sends in progress to all the neighbours
+	virtual bool progress() {
+		bool done = true;
+		for (int i=0 ; i<topo.nb_neighbour() ; i++) done = out[i].progress() && done;
+		return gout.progress() && done;
+	}
+	/// Wait for the completion of the sends in progress to all the neighbours
+	virtual void flush() {
+		for (int i=0 ; i<topo.nb_neighbour() ; i++) out[i].flush();
+		gout.flush();
+	}
+
 	/** WORK **/
-	/// Send work or not
+	/** Send work or not
+	* The nodes are sent until their weight in the load metric of the
+	* priority queue reaches lm (one per node with the default metric).
+	* The nodes are sent by chunks of WORK_CHUNK bytes, each chunk is sent
+	* as soon as it is packed, so the receiver could insert the nodes of the
+	* first chunks while the next ones are packed.
+	*/
 	// TODO Careful: DelLB get nodes from a set of real PQ
 	virtual int send_work(int neighbour, long lm) {
 		int rank = topo.neighbour2rank(neighbour);
 		TheNode *n;
-		long nb = 0;
+		long nb = 0, w = 0;
 
 		out[neighbour].reset();
 
 		n = 0;
-		while( nb < lm ) {
+		while( w < lm ) {
 			while ( n==0 && !pq->are_all_wait() ) {
 				pq->set_need_node4LB(1);
 				n = pq->DelLB();
 			}
 			if ( n!=0 ) {
+				w += pq->Weight(n);
 				out[neighbour].pack_node(n); 
 				pq->set_need_node4LB(0);
 				n = 0;
 				nb++;
+				if ( out[neighbour].size() >= WORK_CHUNK && w < lm ) {
+					out[neighbour].pack_chunk();
+					out[neighbour].send(rank, "work chunk", TAG_WORK);
+					DBG_STRAT("sends a WORK chunk to " << rank << " (" << nb << " nodes)");
+				}
 			}
 			else { break; }
 		}
@@ -430,7 +609,7 @@ public:
 			out[neighbour].pack_finish();
 			pack_load(neighbour);
 			out[neighbour].send(rank, "work",TAG_WORK);
-			load[neighbour] += nb;
+			load[neighbour] += w;
 			DBG_STRAT("sends WORK to " << rank << " (" << nb << " nodes)");
 		}
 		else {
@@ -440,7 +619,10 @@ public:
 		}
 		return nb;
 	}
-	/// Receive work
+	/** Receive work
+	* receives one chunk of a work message, the request for work is
+	* satisfied when the last chunk is received.
+	*/
 	virtual int receive_work(int rank) {
 		int neighbour = topo.rank2neighbour(rank);
 		int header = HEADER_FINISH, nb = 0;
@@ -448,15 +630,17 @@ public:
 		in[neighbour].recv(rank, TAG_WORK);
 
 		header = in[neighbour].unpack_header();
-		while ( header != HEADER_FINISH ) {
+		while ( header == HEADER_NODE ) {
 			TheNode *n = new TheNode();
 			in[neighbour].unpack_node(n);
 			pq->Ins(n); // computation threads are automatically awaken by "Ins"
 			nb++;
 			header = in[neighbour].unpack_header();
 		}
-		unpack_load(neighbour);
-		asking[neighbour] = false;
+		if ( header == HEADER_FINISH ) {
+			unpack_load(neighbour);
+			asking[neighbour] = false;
+		}
 		DBG_STRAT("receives WORK from " << rank << " (" << nb << " nodes)");
 		return nb;
 	}
@@ -470,42 +654,83 @@ public:
 	}
 
 	/** GOAL **/
-	/// Send the goal
-	virtual void send_incubent(int neighbour) {
+	/** Only the key of the incubent is exchanged during the search, it is gossiped
+	* through the topology: a process sends the key to its neighbours when its own
+	* solution or a received key improves the key it has sent.
+	* The solution itself is collected by the main process at the end.
+	*/
+	/// Send the key of the incubent to a neighbour
+	virtual void send_incubent(int neighbour, double k) {
 		int rank = topo.neighbour2rank(neighbour);
 		DBG_STRAT("sends GOAL to " << rank);
 		out[neighbour].reset();
-		out[neighbour].pack_incubent(goal);
+		out[neighbour].pack_key(k);
 		out[neighbour].send(rank, "incubent", TAG_GOAL);
 	}
-	/// Broadcast the goal
-	virtual void broadcast_incubent() {
-printf("Broadcast de la solution...\n");
-		for (int i=0 ; i<topo.nb_neighbour() ; i++) send_incubent(i); }
-	/// Receive the goal
+	/// Broadcast the key of the incubent to the neighbours
+	virtual void broadcast_incubent(double k) { for (int i=0 ; i<topo.nb_neighbour() ; i++) send_incubent(i, k); }
+	/** Broadcast the key of the incubent if it is improved, the improvements
+	* within INC_WINDOW seconds are coalesced in one message.
+	*/
+	virtual void gossip_incubent() {
+		double k = goal->inc_key();
+		if ( !(k < inc_sent) ) return;
+		double t = core::mTime();
+		if ( t - inc_time < INC_WINDOW ) return;
+		inc_sent = k;
+		inc_time = t;
+		broadcast_incubent(k);
+	}
+	/// Receive the key of the incubent, the pruning of the nodes uses it at once
 	virtual void receive_incubent(int rank) {
 		DBG_STRAT("receives GOAL from " << rank);
 		int neighbour = topo.rank2neighbour(rank);
 		in[neighbour].recv(rank, TAG_GOAL);
-		Goal tempg;
-		goal->current_merge(&tempg);
+		double k = in[neighbour].unpack_key();
+		goal->update_key(k);
+		// a process with only one neighbour does not send back the key
+		if ( k < inc_sent && topo.nb_neighbour() == 1 ) inc_sent = k;
+	}
+	/** Collect the solution at the end of the search, the main process receives
+	* the goal of the processes which store the solution of the best key.
+	*/
+	virtual void collect_incubent() {
+		if ( topo.is_main() ) {
+			for (int i=0 ; i<EnvProg::nproc() ; i++) {
+				if ( i==EnvProg::rank() ) continue;
+				gin.recv(i, TAG_SOL);
+				if ( gin.unpack_header() == HEADER_NODE ) {
+					Goal tempg;
+					gin.unpack_incubent(&tempg);
+					goal->final_merge(&tempg);
+				}
+			}
+		} else {
+			DBG_STRAT("sends SOL to " << topo.main_rank());
+			gout.reset();
+			if ( goal->holds_inc() ) {
+				gout.pack_header(HEADER_NODE);
+				gout.pack_incubent(goal);
+			} else {
+				gout.pack_header(HEADER_FINISH);
+			}
+			gout.send(topo.main_rank(), "solution", TAG_SOL);
+		}
 	}
 
 	/** END **/
 	/// Send the end
-	virtual void send_kill(int neighbour) {
-		int rank = topo.neighbour2rank(neighbour);
+	virtual void send_kill(int rank) {
 		DBG_STRAT("sends END to " << rank);
-		out[neighbour].reset();
-		out[neighbour].send(rank, "end", TAG_END);
+		gout.reset();
+		gout.send(rank, "end", TAG_END);
 	}
 	/// Broadcast the end
-	virtual void broadcast_kill() { for (int i=0 ; i<topo.nb_neighbour() ; i++) send_kill(i); }
+	virtual void broadcast_kill() { for (int i=0 ; i<EnvProg::nproc() ; i++) if ( i!=EnvProg::rank() ) send_kill(i); }
 	/// Receive the end
 	virtual void receive_end(int rank) {
 		DBG_STRAT("receives END from " << rank);
-		int neighbour = topo.rank2neighbour(rank);
-		in[neighbour].recv(rank, TAG_END);
+		gin.recv(rank, TAG_END);
 	}
 };
 
@@ -565,7 +790,7 @@ public:
 
 		share = (sum_over + sum_under) / 2;
 		my_diff_load = diff_load[strat_base::topo.nb_neighbour()];
-		// the test with 'asking' here avoids a bug when 2 MPI_Send with big data are launched in the same time => deadlock
+		// no work is sent to a neighbour from which work is asked
 		if (my_diff_load > 0 && diff_load[neighbour] < 0 && !strat_base::asking[neighbour]) {
 			share = round(-diff_load[neighbour]*my_diff_load/share);
 		} else { share = 0; }
@@ -585,9 +810,10 @@ public:
 		bool action (false);
 		// in & out stats
 		int nb_nodes_in (0), nb_nodes_out (0);
+		// nodes have been received since the previous end token
+		bool dirty (false);
 		// management of the message
-		int flag = 0;
-		MPI_Status message_status;
+		int source = 0, tag = 0;
 
 // TODO : ne pas afficher la racine + "start to solve the entire tree", etc. sauf pour le process 0
 // (sûrement des choses à faire dans thr.h, ligne 1092, on peut jouer avec la verbosity ?? (j'ai essayé sans succès)
@@ -602,6 +828,8 @@ public:
 		DBG_STRAT("begins the strat loop with load = " << strat_base::pq->Load());
 		// main loop for messages management
 		while (state != STOPPING) {
+			// recycle the buffers of the completed sends
+			strat_base::progress();
 			// update my load + compute: average & min & max loads + prepare misc arrays
 			compute_thresholds();
 			// Must I send load?
@@ -612,17 +840,13 @@ public:
 			}
 			// Must I ask for work?
 			if (underloaded()) { send_askwork(); }
-			// Must I send the goal?
-			if (strat_base::goal->is_updated()) {
-				strat_base::broadcast_incubent();
-				strat_base::goal->reset_state();
-			}
+			// Must I send the key of the goal?
+			strat_base::gossip_incubent();
 			// Incoming message?
-			MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &message_status);
-			if (flag) {
-				switch (message_status.MPI_TAG) {
+			if (strat_base::gin.iprobe(source, tag)) {
+				switch (tag) {
 					case TAG_TOKEN:
-						strat_base::receive_token(message_status.MPI_SOURCE);
+						strat_base::receive_token(source);
 						switch (strat_base::topo.token.mode) {
 							case TOKEN_MODE_LOAD:
 								DBG_COMM("TOKEN LOAD received");
@@ -631,13 +855,15 @@ public:
 									DBG_STRAT("begins TOKEN END");
 									strat_base::update_myload();
 									strat_base::topo.token.set_mode(TOKEN_MODE_END);
+									dirty = false;
 									strat_base::send_token();
 								}
 								else { token = true; }
 								break;
 							case TOKEN_MODE_END:
 								DBG_STRAT("TOKEN END received");
-								strat_base::topo.token.update_stats(nb_nodes_in, nb_nodes_out);
+								strat_base::topo.token.update_stats(nb_nodes_in, nb_nodes_out, dirty);
+								dirty = false;
 								if (strat_base::pq->are_all_wait() && strat_base::pq->Load() <= 0) {
 									if (strat_base::topo.token.ring_completed()) {
 										if (strat_base::topo.token.verify_stats())  {
@@ -665,34 +891,42 @@ public:
 						}
 						break;
 					case TAG_LOAD:
-						strat_base::receive_load(message_status.MPI_SOURCE);
+						strat_base::receive_load(source);
 						action = true;
 						break;
 					case TAG_ASKWORK:
-						strat_base::receive_askwork(message_status.MPI_SOURCE);
+						strat_base::receive_askwork(source);
 						compute_thresholds();
-						nb_nodes_out += send_work(message_status.MPI_SOURCE);
+						nb_nodes_out += send_work(source);
 						action = true;
 						break;
 					case TAG_NOWORK:
-						strat_base::receive_nowork(message_status.MPI_SOURCE);
+						strat_base::receive_nowork(source);
 						action = true;
 						break;
 					case TAG_WORK:
-						nb_nodes_in += strat_base::receive_work(message_status.MPI_SOURCE);
+						nb_nodes_in += strat_base::receive_work(source);
+						dirty = true;
 						action = true;
 						break;
 					case TAG_GOAL:
-						strat_base::receive_incubent(message_status.MPI_SOURCE);
+						strat_base::receive_incubent(source);
 						action = true;
 						break;
 					case TAG_END:
-						strat_base::receive_end(message_status.MPI_SOURCE);
+						strat_base::receive_end(source);
+						state = STOPPING;
+						action = true;
+						break;
+					case TAG_SOL:
+					case TAG_STAT:
+						// the sender has already received the end, this one is still in progress,
+						// the solution and the statistics are received after the loop
 						state = STOPPING;
 						action = true;
 						break;
 					default:
-						std::cout << EnvProg::rank() << ": Tag=" << message_status.MPI_TAG << " not known" << " from " << message_status.MPI_SOURCE << std::endl;
+						std::cout << EnvProg::rank() << ": Tag=" << tag << " not known" << " from " << source << std::endl;
 						exit(0);
 				}
 			}
@@ -708,6 +942,8 @@ public:
 			// adaptive wait
 			usleep(sleeptime);
 		}
+		strat_base::collect_incubent();
+		strat_base::flush();
 		strat_base::pq->wake_up_for_end();
 		DBG_STRAT("finishes the strat loop");
 	}
@@ -730,6 +966,44 @@ public:
 	}
 }; // class lb_strat_2t
 
+/** randomized work stealing strategy
+  * an underloaded process asks work to a random neighbour, the victim sends
+  * half of its load balancing queue or nothing, then the thief chooses another
+  * victim. Only one request is pending at a time, and no load is pushed by
+  * the overloaded processes. The termination is detected by the token of
+  * lb_strat_2t.
+  */
+template<class Trait,class Topo, class PQ, class Goal,class Load=long>
+	class lb_strat_ws : public lb_strat_2t<Trait,Topo,PQ,Goal,Load> {
+	typedef lb_strat<Trait,Topo,PQ,Goal,Load> strat_base; /**< type of the base strategy */
+	unsigned int seed; /**< the seed to choose the victims */
+
+public:
+	/// Constructor
+	lb_strat_ws(PQ *_pq, Goal *_g) : lb_strat_2t<Trait,Topo,PQ,Goal,Load>(_pq,_g), seed(EnvProg::rank()+1) { }
+	/// Destructor
+	virtual ~lb_strat_ws() { }
+	/// Ask for work to a random neighbour if no request is pending
+	virtual void send_askwork() {
+		int nb = strat_base::topo.nb_neighbour();
+		if ( nb==0 ) return;
+		for (int i=0 ; i<nb ; i++) { if ( strat_base::asking[i] ) return; }
+		strat_base::send_askwork(rand_r(&seed) % nb);
+	}
+	/// The load is never pushed
+	virtual void send_load() { }
+	/// Send half of the load balancing queue
+	virtual int send_work(int rank) {
+		int neighbour = strat_base::topo.rank2neighbour(rank);
+		long share = 0;
+		// no work is sent to a neighbour from which work is asked
+		if ( !strat_base::asking[neighbour] ) { share = strat_base::pq->Load()/2; }
+		return strat_base::send_work(neighbour, share);
+	}
+	/// a process steals work when its load balancing queue is empty
+	virtual bool underloaded() { return strat_base::pq->Load() == 0; }
+}; // class lb_strat_ws
+
 }; // end of namespace mpx
 }; // end of namespace Bob
 #endif
@@ -11,6 +11,135 @@ int ThrEnvProg::nbth = 0;
 int ThrEnvProg::nbpq = 1;
 int ThrEnvProg::cpuset_sz = 0;
 bool ThrEnvProg::multi_inst = false;
+int ThrEnvProg::spin_idle = -1;
+int ThrEnvProg::ramp_k = 0;
+int ThrEnvProg::pf_n = 0;
+
+int ThrReplay::mode = ThrReplay::Off;
+ThrMutex ThrReplay::mut;
+std::vector<std::pair<int,long> > ThrReplay::runs;
+volatile long ThrReplay::cur = 0;
+volatile long ThrReplay::done = 0;
+std::vector<long> ThrReplay::remain;
+int ThrReplay::nb = 0;
+std::string ThrReplay::rec;
+std::string ThrReplay::rep;
+/// the nesting level of the operations of the calling thread
+static __thread int replay_nest = 0;
+/// the rank of the calling thread, -1 if it is not known
+static __thread int replay_rank = -1;
+
+void ThrReplay::init() {
+  core::opt().add(std::string("--thr"), Property("-rec", "file to record the order of the operations of the threads", "", &rec));
+  core::opt().add(std::string("--thr"), Property("-rep", "file of a recorded run to replay", "", &rep));
+}
+
+void ThrReplay::start(int nbth, bool cth) {
+  mode = Off;
+  nb = nbth;
+  if (rec.empty() && rep.empty()) return;
+  if (cth) {
+    std::cerr << "--thr -rec and -rep are not available with a communication thread\n";
+    return;
+  }
+  runs.clear();
+  cur = done = 0;
+  if (!rec.empty()) {
+    mode = Record;
+    return;
+  }
+  std::ifstream f(rep.c_str());
+  std::string h;
+  int r;
+  long c;
+  if (!(f >> h >> nb) || h != "bobpp-replay") {
+    std::cerr << "cannot read the replay file " << rep << "\n";
+    exit(1);
+  }
+  if (nb != nbth) {
+    std::cerr << "the replay file " << rep << " is recorded with " << nb << " threads\n";
+    exit(1);
+  }
+  remain.assign(nb + 1, 0);
+  while (f >> r >> c) {
+    if (r < 0 || r > nb || c <= 0) {
+      std::cerr << "bad run in the replay file " << rep << "\n";
+      exit(1);
+    }
+    runs.push_back(std::make_pair(r, c));
+    remain[r] += c;
+  }
+  mode = Replay;
+  std::cout << "Replay of " << rep << " (" << runs.size() << " runs)\n";
+}
+
+void ThrReplay::end() {
+  if (mode == Record) {
+    std::ofstream f(rec.c_str());
+    f << "bobpp-replay " << nb << "\n";
+    for (unsigned int i = 0; i < runs.size(); i++) {
+      f << runs[i].first << " " << runs[i].second << "\n";
+    }
+    if (!f) {
+      std::cerr << "cannot write the replay file " << rec << "\n";
+    }
+  }
+  mode = Off;
+}
+
+int ThrReplay::begin_op(bool last) {
+  int r = replay_rank;
+  if (r < 0) {
+    // the operations of the other threads are logged with the rank nb
+    r = ThrEnvProg::algo_rank();
+    if (r >= 0) replay_rank = r;
+    else r = nb;
+  }
+  if (replay_nest++ > 0) return r;
+  if (mode == Record) {
+    mut.lock();
+    return r;
+  }
+  // the thread waits its turn
+  while (true) {
+    if (remain[r] == 0) {
+      if (last) {
+        replay_nest--;
+        return Done;
+      }
+      diverge("operation");
+    }
+    if (cur < (long)runs.size() && runs[cur].first == r) break;
+    sched_yield();
+  }
+  return r;
+}
+
+void ThrReplay::end_op(int r, bool d) {
+  if (--replay_nest > 0) return;
+  if (mode == Record) {
+    if (d) {
+      if (!runs.empty() && runs.back().first == r) runs.back().second++;
+      else runs.push_back(std::make_pair(r, 1L));
+    }
+    mut.unlock();
+    return;
+  }
+  if (!d) return;
+  remain[r]--;
+  if (++done == runs[cur].second) {
+    done = 0;
+    // the operation is visible before the turn is given to the next thread
+    __sync_synchronize();
+    cur++;
+  }
+}
+
+void ThrReplay::diverge(const char *op) {
+  std::cerr << "the replay of " << rep << " differs from the recorded run (" << op
+            << " of the thread " << ThrEnvProg::algo_rank() << " at the run " << cur << ")\n";
+  exit(1);
+}
 
 void *GoThread(void *a) {
   Thread *t = (Thread *)a;
@@ -45,6 +174,7 @@ void *GoThread(void *a) {
 #endif
 
   t->loop();
+  NodePool::thread_end();
   return 0;
 }
 
@@ -62,7 +192,7 @@ void Thread::loop() {
   cond.lock();
   if (state == ThWait)  {
     DBGAFF_ENV("Thread::loop","Thread is waiting");
-    cond.wait();
+    while (state == ThWait) cond.wait();
     DBGAFF_ENV("Thread::loop","Wake up after first wait");
   } 
   while (state != ThStop) {
@@ -95,7 +225,7 @@ void Thread::loop() {
     }
     state = ThWait;
     DBGAFF_ENV("Thread::loop","Thread is waiting");
-    cond.wait();
+    while (state == ThWait) cond.wait();
     DBGAFF_ENV("Thread::loop","Wake up after wait");
   }
   cond.unlock();
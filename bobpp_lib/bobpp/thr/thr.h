@@ -3,6 +3,7 @@
 #define BOB_THRENVPROG
 
 #include<pthread.h>
+#include<sched.h>
 #ifndef PTHREAD_STACK_MIN
 #define PTHREAD_STACK_MIN  16384
 #endif
@@ -63,47 +64,21 @@ namespace Bob {
   * We propose here a simple object oriented implementation of the classical synchronization routines.
   * @{
   */
-//#define USE_TIME_MUTEX
-
-/** macro used to log the time spent in the mutex.
-  * if you define USE_TIME_MUTEX, each mutex used in the thr implementation
-  * uses a stat_timer to display the time spent in the mutex at the end of 
-  * the execution.
-  */ 
-#ifdef USE_TIME_MUTEX
-/// declaration of the stat_timer
-#define UTM_DECL stat_timer tm;
-/// initialisation of the stat_timer
-#define UTM_INIT :tm()
-/// begin the stat_timer
-#define UTM_START tm.start()
-/// end the stat_timer
-#define UTM_END tm.end()
-/// display the stat_timer
-#define UTM_DISP os<<tm<<"\n";
-#else
-/// declaration of the stat_timer
-#define UTM_DECL 
-/// initialisation of the stat_timer
-#define UTM_INIT 
-/// begin the stat_timer
-#define UTM_START 
-/// end the stat_timer
-#define UTM_END 
-/// display the stat_timer
-#define UTM_DISP
-#endif
 
 /** Class that represents a thread mutex
- * This class can also logs the time lost to lock the mutex.
+ * This class also measures the time lost to lock the mutex. The time is only
+ * measured when the mutex is already locked, and the stat_timer is updated
+ * once the mutex is acquired, then the stat_timer is protected by the mutex itself.
+ * The waits are displayed with the -- -sh option.
  */
 struct ThrMutex {
   /// The POSIX mutex
   pthread_mutex_t mut;
-  UTM_DECL
+  /// the waits on the mutex
+  stat_timer tm;
 public:
   /// Constructor
-  ThrMutex() UTM_INIT {
+  ThrMutex() : tm(0) {
     pthread_mutex_init(&mut, 0);
   };
   /// destructor
@@ -112,9 +87,17 @@ public:
   };
   /// Method to lock the mutex
   virtual void lock() {
-    UTM_START;
-    pthread_mutex_lock(&mut);
-    UTM_END;
+    if (pthread_mutex_trylock(&mut) != 0) {
+      double t = core::mTime();
+      pthread_mutex_lock(&mut);
+      tm.add_time(core::mTime() - t);
+    }
+  }
+  /** Method to lock the mutex only if it is free
+    * @return true if the mutex has been locked
+    */
+  virtual bool trylock() {
+    return pthread_mutex_trylock(&mut) == 0;
   }
   /// Method to unlock the mutex
   virtual void unlock() {
@@ -122,7 +105,9 @@ public:
   }
   /// Method to display the lock waiting time.
   virtual void display(std::ostream &os) const {
-    UTM_DISP;
+    if (!core::disp_histo() || tm.getn() == 0) return;
+    os << "Lock waits " << tm.getn() << ":" << tm.getc() << "\n";
+    tm.display_histo(os);
   }
 };
 
@@ -152,9 +137,19 @@ public:
   }
   /// wait method
   void wait() {
-    UTM_START;
     pthread_cond_wait(&cond, &mut);
-    UTM_END;
+  }
+  /** wait method with a timeout
+    * @param sec the maximum waiting time in seconds
+    * @return false if the timeout is reached
+    */
+  bool timedwait(double sec) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    long ns = ts.tv_nsec + (long)((sec - (long)sec) * 1e9);
+    ts.tv_sec += (long)sec + ns / 1000000000L;
+    ts.tv_nsec = ns % 1000000000L;
+    return pthread_cond_timedwait(&cond, &mut, &ts) == 0;
   }
   /// Signal method
   void signal() {
@@ -164,7 +159,10 @@ public:
 
 
 /** Class to implement a barrier between the Threads
- *
+ * The barrier is reused for each search: a generation counter is incremented
+ * when the last thread arrives, a thread waits until the generation changes.
+ * Hence a thread which has not yet left the previous barrier when the
+ * next one is set (setNb()) is not lost, and spurious wakeups are harmless.
  */
 struct ThrBarrier {
   /// The POSIX condition variable
@@ -173,30 +171,35 @@ struct ThrBarrier {
   volatile int n;
   /// the number of thread that currently wait for the barrier
   volatile int nbw;
+  /// the generation of the barrier, incremented when all the threads are arrived
+  volatile long gen;
 public:
   /// Constructor
-  ThrBarrier(int _n = 0): cond(),n(_n), nbw(0) {
+  ThrBarrier(int _n = 0): cond(),n(_n), nbw(0), gen(0) {
   }
   /// Destructor
   virtual ~ThrBarrier() {
   }
   /// Set the number of Thread to wait.
   virtual void setNb(int _n) {
+    cond.lock();
     n = _n;
     nbw=0;
-    cond.reset();
+    cond.unlock();
   }
   /// Method called by the different thread to wait, the last one will broadcast to everyone.
   virtual void Wait() {
     cond.lock();
+    long g = gen;
     nbw++;
     if (n <= nbw) {
+      nbw = 0;
+      gen++;
       cond.bcast();
-      cond.unlock();
     } else {
-      cond.wait();
-      cond.unlock();
+      while (g == gen) cond.wait();
     }
+    cond.unlock();
   }
 };
  /** @}
@@ -279,6 +282,91 @@ public:
   virtual long nb();
 };
 
+/** The static class to record and to replay a parallel search.
+ * The order of the searches depends on the timing of the threads, hence the
+ * number of explored nodes changes from one run to another.
+ * With the option --thr -rec file, the operations on the shared data structures
+ * (insertions and deletions in the priority queue, tests and updates of the goal)
+ * are serialized and the rank of the thread that performs each operation is
+ * logged in the file, as runs of operations of the same thread.
+ * With the option --thr -rep file, each thread waits its turn before each
+ * operation, the operations are then performed in the recorded order and
+ * the search explores the same nodes in the same order, while the threads
+ * still compute the children in parallel.
+ * The operations of the main thread are logged with the rank n_algo_thread().
+ * The record and the replay are not available with a communication thread
+ * (MPx environment), the stops on a time limit or on a gap are not replayed.
+ */
+class ThrReplay {
+  /// the mode of the environment: Off, Record or Replay
+  static int mode;
+  /// the mutex that serializes the operations while recording
+  static ThrMutex mut;
+  /// the runs of operations, the rank of the thread and the number of operations
+  static std::vector<std::pair<int,long> > runs;
+  /// the index of the current run while replaying
+  static volatile long cur;
+  /// the number of operations done in the current run while replaying
+  static volatile long done;
+  /// the number of remaining operations of each thread while replaying
+  static std::vector<long> remain;
+  /// the number of threads of the recorded run
+  static int nb;
+  /// the name of the file to record
+  static std::string rec;
+  /// the name of the file to replay
+  static std::string rep;
+  /// the begin of an operation when the mode is not Off
+  static int begin_op(bool last);
+  /// the end of an operation when the mode is not Off
+  static void end_op(int r, bool d);
+public:
+  /// the modes of the environment
+  enum { Off, Record, Replay };
+  /// the value returned by begin() when the thread has no operation to replay
+  static const int Done = -2;
+  /// register the options
+  static void init();
+  /** starts the record or loads the file to replay
+    * @param nbth the number of search threads
+    * @param cth true if a communication thread is used
+    */
+  static void start(int nbth, bool cth);
+  /// writes the recorded file
+  static void end();
+  /// true if the search is recorded or replayed
+  static bool active() {
+    return mode != Off;
+  }
+  /// true if the search is replayed
+  static bool replaying() {
+    return mode == Replay;
+  }
+  /** Method called before an operation on a shared data structure.
+    * The nested operations are not logged.
+    * @param last true if the operation could be the last one of the thread
+    * (a deletion), Done is then returned when no operation remains.
+    * @return the rank of the thread, -1 if the mode is Off
+    */
+  static int begin(bool last=false) {
+    if (mode == Off) return -1;
+    return begin_op(last);
+  }
+  /** Method called after an operation on a shared data structure.
+    * @param r the value returned by begin()
+    * @param d false if the operation has not been done (a deletion
+    * that finds no node), it is not logged.
+    */
+  static void end(int r, bool d=true) {
+    if (mode == Off) return;
+    end_op(r, d);
+  }
+  /** Stops the program when the replay differs from the recorded run.
+    * @param op the name of the operation
+    */
+  static void diverge(const char *op);
+};
+
 /** The threaded Environment static class
  * The threaded environment need a static class.
  * This class is used to store the threaded specific parameters (i.e. --thr). 
@@ -299,6 +387,14 @@ protected:
   static int cpuset_sz;
   /// Boolean to know if the instance is duplicated in each thread/algo or not.
   static bool multi_inst;
+  /** Number of spin iterations of an idle thread before it parks, -1 to choose it 
+    * at the start : the threads spin only if each of them has its own processor.
+    */
+  static int spin_idle;
+  /// Number of nodes per thread at the end of the ramp-up (0 = no ramp-up).
+  static int ramp_k;
+  /// Number of threads of the first strategy of a portfolio (0 = half).
+  static int pf_n;
 public:
   /// Constructor
   ThrEnvProg() { }
@@ -312,6 +408,10 @@ public:
     core::opt().add(std::string("--thr"), Property("-c", "cpuset size (0=compute)",0, &cpuset_sz));
 #endif
     core::opt().add(std::string("--thr"), Property("-s", "the Stack size used by each thread", (int)(PTHREAD_STACK_MIN*10)));
+    core::opt().add(std::string("--thr"), Property("-w", "Number of spin iterations of an idle thread before it parks (-1=100, or 0 if there are more threads than processors)", -1, &spin_idle));
+    core::opt().add(std::string("--thr"), Property("-ru", "ramp-up: the tree is expanded breadth first until k nodes per thread (0=no ramp-up)", 0, &ramp_k));
+    core::opt().add(std::string("--thr"), Property("-pf", "portfolio: number of threads of the first strategy (0=half)", 0, &pf_n));
+    ThrReplay::init();
     comm_th = _cth;
   }
   /// The start method of the environment, the real threads are created
@@ -322,6 +422,11 @@ public:
       std::cerr << "Number of thread 0\n";
       exit(1);
     }
+    if (spin_idle < 0) {
+      // an oversubscribed thread that spins only delays the thread that would wake it up
+      spin_idle = (nbth + (comm_th != 0 ? 1 : 0) > n_cpu() ? 0 : 100);
+    }
+    ThrReplay::start(nbth, comm_th != 0);
     tt = new Thread[nbth];
     for (int i = 0; i < nbth; i++)
       tt[i].init();
@@ -333,17 +438,25 @@ public:
       pthread_join(tt[i].id, NULL);
     }
     delete[] tt;
+    tt = 0;
+    ThrReplay::end();
+    NodePool::reclaim();
   }
   /// Search the rank of a thread.
   static int rank() {
+    int r = algo_rank();
+    return (r < 0 ? 0 : r);
+  }
+  /// Search the rank of a search thread, -1 for the other threads.
+  static int algo_rank() {
     int i;
-    if (tt == 0) return 0;
+    if (tt == 0) return -1;
     for (i = 0; i < n_algo_thread(); i++) {
       if (pthread_equal(tt[i].thid(), pthread_self())) {
         return i;
       }
     }
-    return 0;
+    return -1;
   }
   /// get the value of the option multi_inst.
   static bool instance_multi() {
@@ -357,6 +470,37 @@ public:
   static int npq() {
     return nbpq;
   }
+  /// Method that returns the number of processors the process may run on
+  static int n_cpu() {
+#ifdef BOBPP_HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t cs;
+    if (sched_getaffinity(0, sizeof(cs), &cs) == 0) return CPU_COUNT(&cs);
+#endif
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  /// Method that returns the number of spin iterations before an idle thread parks
+  static int idle_spin() {
+    return spin_idle;
+  }
+  /// Method that returns the number of nodes per thread at the end of the ramp-up
+  static int ramp_up() {
+    return ramp_k;
+  }
+  /** Method that returns the number of threads of the first strategy of a 
+    * portfolio (see ThrPortfolioAlgoEnvProg), the other threads run the second one.
+    */
+  static int portfolio_split() {
+    if (nbth < 2) return nbth;
+    if (pf_n <= 0) return nbth / 2;
+    return (pf_n < nbth ? pf_n : nbth - 1);
+  }
+  /** Method that returns the strategy of the calling thread in a portfolio, 
+    * it could be used to choose the heuristics of the GenChild.
+    * @return 0 for the first strategy, 1 for the second one.
+    */
+  static int strategy() {
+    return (rank() < portfolio_split() ? 0 : 1);
+  }
   /// Method that returns the size of a cpuset
   static int cpuset_size() {
     return (cpuset_sz==0 ? nbth/nbpq : cpuset_sz);
@@ -445,13 +589,18 @@ public:
     mut.unlock();
   }
   /** Method to test if the node is suitable to be explore later.
+    * The nodes pruned by the key of the incumbent are rejected without locking the goal.
     * @param n the node to test
     */
   virtual bool is4Search(TheNode *n) {
-    bool b;
-    mut.lock();
-    b = TheGoal::is4Search(n);
-    mut.unlock();
+    bool b = false;
+    int r = ThrReplay::begin();
+    if ( !TheGoal::is_pruned(n) ) {
+      mut.lock();
+      b = TheGoal::is4Search(n);
+      mut.unlock();
+    }
+    ThrReplay::end(r);
     return b;
   }
   /** Method called when a node is a solution
@@ -460,9 +609,11 @@ public:
     */
   virtual bool update(TheNode *n, int u=0) {
     bool b;
+    int r = ThrReplay::begin();
     mut.lock();
     b = TheGoal::update(n,u);
     mut.unlock();
+    ThrReplay::end(r);
     return b;
   }
   /** The merging method is used to update the goal with another one.
@@ -472,9 +623,11 @@ public:
   virtual bool current_merge(const TheGoal *g) {
     bool b;
 
+    int r = ThrReplay::begin();
     mut.lock();
     b = TheGoal::current_merge(g);
     mut.unlock();
+    ThrReplay::end(r);
     return b;
   }
   /** The merging method is used to update the goal with another one.
@@ -483,9 +636,11 @@ public:
     */
   virtual bool final_merge(const TheGoal *g) {
     bool b;
+    int r = ThrReplay::begin();
     mut.lock();
     b = TheGoal::final_merge(g);
     mut.unlock();
+    ThrReplay::end(r);
     return b;
   }
   /** Method to display the Goal.
@@ -496,6 +651,24 @@ public:
     mut.display(os);
     return os;
   };
+  /** Write the metrics of the goal, the metrics sampler does not wait 
+    * for the goal: nothing is written if the goal is locked.
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) {
+    if ( !mut.trylock() ) return;
+    TheGoal::Metrics(os);
+    mut.unlock();
+  }
+  /** Write the bound and the gap, the metrics are skipped if the goal is locked.
+    * @param os the std::ostream used to write the metrics
+    * @param bk the bound of the search as a key
+    */
+  virtual void MetricsBound(std::ostream &os, double bk) {
+    if ( !mut.trylock() ) return;
+    TheGoal::MetricsBound(os,bk);
+    mut.unlock();
+  }
 
 };
 
@@ -583,6 +756,42 @@ protected:
 
 };
 
+/** Class to store the idle state of one thread on a ThrPQ.
+ * An idle thread first spins on the priority queue, then parks itself on
+ * its own condition variable. An inserting thread wakes only one parked
+ * thread, using the parked flag to find it.
+ */
+struct ThrIdleSlot {
+  /// the condition variable used to park the thread
+  ThrCond cond;
+  /// 1 if the thread is parked on the condition variable
+  volatile int parked;
+  /// 1 if the thread has been woken up by an insertion
+  volatile int wake;
+  /// the cumulated idle time of the thread
+  volatile double idlet;
+  /// the beginning of the current idle period (0 if the thread is not idle)
+  volatile double idls;
+  /// the key of the last node deleted by the thread (HUGE_VAL if the thread is idle)
+  volatile double key;
+  /// Constructor
+  ThrIdleSlot() : cond(),parked(0),wake(0),idlet(0),idls(0),key(HUGE_VAL) {}
+  /// Copy constructor (only used to size the vector)
+  ThrIdleSlot(const ThrIdleSlot &) : cond(),parked(0),wake(0),idlet(0),idls(0),key(HUGE_VAL) {}
+};
+
+/** Class to store the best key of an internal priority queue of a ThrPQ,
+ * that is read without locking the priority queue.
+ */
+struct ThrBestKey {
+  /// the best key
+  volatile double k;
+  /// Constructor
+  ThrBestKey() : k(HUGE_VAL) {}
+  /// Copy constructor (only used to size the vector)
+  ThrBestKey(const ThrBestKey &) : k(HUGE_VAL) {}
+};
+
 /** Class to represent the priority queue use by several threads
  *
  * This class uses the Bob::ThrMutex for the access to the
@@ -592,19 +801,65 @@ protected:
  * if the priority queue is empty. A thread must have to wait, 
  * until another thread inserts a new node.
  * The terminaison arrives if all threads are waiting.
+ *
+ * The number of idle threads is maintained with atomic operations,
+ * the value ThrPQ::Term stored in Wth means that the search is ended.
+ * An idle thread spins (see the --thr -w option) before parking on its
+ * own ThrIdleSlot, and an insertion only wakes one parked thread.
+ *
+ * The best key of each internal priority queue is updated under its lock, and each 
+ * thread stores the key of the last node it has deleted, then the bound of the search 
+ * (see BestKey()) is computed without any lock.
+ *
+ * With the -- -ft_period option, the ThrAlgoEnvProg takes periodic checkpoints
+ * of the search : the threads are paused at their next safepoint (between two
+ * node explorations), and when each thread is paused or idle, all the nodes
+ * are in the internal priority queues which are packed without removing the nodes.
+ *
+ * With the --thr -ru k option, the search begins with a ramp-up (see ramp_up()) :
+ * the tree is expanded breadth first, one level at a time by all the threads, 
+ * until the frontier stores k nodes per thread. The nodes of the frontier are 
+ * then dealt round-robin to the internal priority queues and the search goes on
+ * with the priority of the nodes. No checkpoint is taken during the ramp-up.
  */
 template<class Node, class PriComp,class Goal,class TheSPQ>
 class ThrPQ : public PQInterface<Node, PriComp,Goal> {
-  ThrCond cond; // the condition variable
-  int Wth;             // number of waiting threads
+  /// value of Wth when the search is ended, and maximum time in seconds to begin a checkpoint
+  enum { Term=100000, CkptTmo=10 };
+  ThrCond cond; // the condition variable (used for the start)
+  ThrCond ckc;  // the condition variable used by the checkpoint
+  volatile int Wth;     // number of waiting threads
+  volatile int paused;  // number of threads paused for a checkpoint
+  volatile long stamp;  // incremented each time an idle thread has to be notified
+  volatile int started; // set to 1 after the first insertion
+  volatile int closed;  // set to 1 when the search is ended by close()
   int Need_NodeforLB;   // flag to manage the load balancing when the ThrPQ is use in distributed environment
   std::vector<TheSPQ *>pq;         // the local priority queue.
   std::vector<ThrMutex> mut; // the associated mutex.
+  std::vector<ThrIdleSlot> idle; // the idle state of each thread.
+  std::vector<ThrBestKey> pqk;    // the best key of each internal priority queue.
+  double mt;                      // the time of the last metrics sample
+  std::vector<double> midle;      // the idle times of the threads at the last metrics sample
+  ThrCond rc;                     // the condition variable of the ramp-up
+  volatile int ramp;              // 1 during the ramp-up
+  long rtarget;                   // the size of the frontier that ends the ramp-up
+  std::vector<Node *> rlvl;       // the nodes of the level expanded during the ramp-up
+  std::vector<Node *> rnext;      // the nodes of the next level
+  unsigned long rpos;             // the index of the next node of rlvl to expand
+  int rbusy;                      // the number of threads that expand a node of rlvl
+  std::vector<char> rhold;        // 1 if the thread expands a node of rlvl
+  ThrBestKey rk;                  // the best key of the nodes of the ramp-up
+  int rlevels;                    // the number of levels expanded by the ramp-up
+  long rfront;                    // the size of the frontier at the end of the ramp-up
+  double rt0, rtime;              // the beginning and the duration of the ramp-up
+  ThrCond *ecnd;                  // the condition variable signaled at the end of the search, could be 0
 public:
 
   /// Constructor
-  ThrPQ(const Id &id,bool l) : PQInterface<Node, PriComp,Goal>(),cond(),Wth(0),Need_NodeforLB(0),
-             pq(ThrEnvProg::npq()), mut(ThrEnvProg::npq()) {
+  ThrPQ(const Id &id,bool l) : PQInterface<Node, PriComp,Goal>(),cond(),ckc(),Wth(0),paused(0),stamp(0),started(0),closed(0),Need_NodeforLB(0),
+             pq(ThrEnvProg::npq()), mut(ThrEnvProg::npq()), idle(ThrEnvProg::n_thread()), pqk(ThrEnvProg::npq()),
+             mt(core::mTime()), midle(ThrEnvProg::n_thread(),0.0), rc(), ramp(0), rtarget(0), rlvl(), rnext(),
+             rpos(0), rbusy(0), rhold(ThrEnvProg::n_thread(),0), rk(), rlevels(0), rfront(0), rt0(0), rtime(0), ecnd(0) {
     for (int i=0;i<ThrEnvProg::npq(); i++ ) {
       pq[i]=0;
     }
@@ -631,6 +886,13 @@ public:
   }
   /// Remove a reference on the Priority Queue
   virtual void remRef() {
+    if ( ramp ) {
+      // the search is stopped during the ramp-up, the nodes are kept for the save
+      rc.lock();
+      if ( ramp ) RampEnd();
+      rc.bcast();
+      rc.unlock();
+    }
     cond.lock();
     PQInterface<Node, PriComp,Goal>::remRef();
     cond.unlock();
@@ -649,38 +911,109 @@ public:
      //std::cout << "r:"<<ThrEnvProg::rank()<<" ip:"<<ip<<" npq:"<<ThrEnvProg::npq()<<"\n";
      return ip;
   }
+  /** Start the ramp-up of the search, the method is called before the 
+    * insertion of the root node.
+    * @param target the size of the frontier that ends the ramp-up
+    */
+  void ramp_up(long target) {
+    rc.lock();
+    ramp = 1;
+    rtarget = target;
+    rt0 = core::dTime();
+    rc.unlock();
+  }
+  /// get the duration of the ramp-up in seconds
+  double ramp_time() const { return rtime; }
   /// Insertion
   virtual void Ins(Node *n) {
+    if ( ramp && RampIns(&n,1) ) return;
+    int r=ThrReplay::begin();
     int ip=getiPQ();
     mut[ip].lock();
     pq[ip]->Ins(n);
+    upd_key(ip);
     mut[ip].unlock();
-    cond.lock();
-    if (Wth > 0) {
-      cond.bcast();
-    } 
-    cond.unlock();
+    ThrReplay::end(r);
+    notify();
+  }
+  /** Insert several nodes with only one lock and one notification
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    */
+  virtual void InsBatch(Node **nds,int nb) {
+    if ( nb<=0 ) return;
+    if ( ramp && RampIns(nds,nb) ) return;
+    int r=ThrReplay::begin();
+    int ip=getiPQ();
+    mut[ip].lock();
+    pq[ip]->InsBatch(nds,nb);
+    upd_key(ip);
+    mut[ip].unlock();
+    ThrReplay::end(r);
+    notify();
+  }
+  /** Delete at most nb nodes with only one lock.
+    * The nodes are deleted from the priority queue associated with the thread,
+    * and the key of the thread is the best key of this priority queue before the
+    * deletion, a bound of all the deleted nodes. If this priority queue is empty, 
+    * only one node is deleted as Del() does (from the other priority queues or 
+    * after an idle wait). During the ramp-up and while the search is recorded or 
+    * replayed, the nodes are deleted one by one. ThrPQ::Del() is called without 
+    * the virtual dispatch : a derived class (see mpx::MPPQ) counts the nodes of the batch.
+    * @param nds the array that receives the deleted nodes
+    * @param nb the maximum number of nodes to delete
+    * @return the number of deleted nodes
+    */
+  virtual int DelBatch(Node **nds,int nb) {
+    if ( nb<=0 ) return 0;
+    if ( nb==1 || closed || ramp || ThrReplay::active() ) return ((nds[0]=ThrPQ::Del())!=0 ? 1 : 0);
+    int ip=getiPQ();
+    mut[ip].lock();
+    int nbd=pq[ip]->DelBatch(nds,nb);
+    if ( nbd>0 ) {
+      del_key(ip);
+      upd_key(ip);
+    }
+    mut[ip].unlock();
+    if ( nbd>0 ) return nbd;
+    return ((nds[0]=ThrPQ::Del())!=0 ? 1 : 0);
   }
   /// Delete greater operation.
   virtual int DelG(Goal &g) {
     int nb=0;
+    if ( ramp ) nb += RampDelG(g);
+    int r=ThrReplay::begin();
     for (int i=0;i<ThrEnvProg::npq();i++ ) {
       mut[i].lock();
       nb += pq[i]->DelG(g);
+      upd_key(i);
       mut[i].unlock();
     }
+    ThrReplay::end(r);
     return nb;
   }
-  /** Method that tries to delete a node from one of the internal priority queues.
+  /** Method that tries to delete a node from one of the internal priority queues,
+   * only the deletions that find a node are recorded.
    * @return the deleted node
    */
   virtual Node *SearchDel() {
+    int r=ThrReplay::begin();
+    Node *n=SearchDelPQ();
+    ThrReplay::end(r,n!=0);
+    return n;
+  }
+  /** Method that deletes a node from one of the internal priority queues.
+   * @return the deleted node
+   */
+  Node *SearchDelPQ() {
     Node *n;
     //int r = ThrEnvProg::rank();
     int ip=getiPQ();
     mut[ip].lock();
     n = pq[ip]->Del();
     if ( n!=0 ) {
+      del_key(ip);
+      upd_key(ip);
       mut[ip].unlock();
       return n;
     }
@@ -691,6 +1024,8 @@ public:
       mut[ip].lock();
       n = pq[ip]->DelLB();
       if ( n!=0 ) {
+        del_key(ip);
+        upd_key(ip);
         mut[ip].unlock();
         return n;
       }
@@ -701,6 +1036,8 @@ public:
       mut[ip].lock();
       n = pq[ip]->Del();
       if ( n!=0 ) {
+        del_key(ip);
+        upd_key(ip);
         mut[ip].unlock();
         return n;
       }
@@ -719,6 +1056,7 @@ public:
     mut[ip].lock();
     n = pq[ip]->DelLB();
     if ( n!=0 ) {
+      upd_key(ip);
       mut[ip].unlock();
       return n;
     }
@@ -729,6 +1067,7 @@ public:
       mut[ip].lock();
       n = pq[ip]->DelLB();
       if ( n!=0 ) {
+        upd_key(ip);
         mut[ip].unlock();
         return n;
       }
@@ -739,6 +1078,7 @@ public:
       mut[ip].lock();
       n = pq[ip]->DelLB();
       if ( n!=0 ) {
+        upd_key(ip);
         mut[ip].unlock();
         return n;
       }
@@ -748,40 +1088,269 @@ public:
     return 0;
   }
 
-  /// Delete the best node
+  /** Method that tests if one of the internal priority queues scanned by 
+   * SearchDel() stores a node.
+   * @return true if a node could be deleted.
+   */
+  virtual bool SearchPeek() {
+    for (int d=-1;d<=1;d++ ) {
+      int ip=getiPQ(d);
+      if ( ip==-1 ) continue;
+      mut[ip].lock();
+      long nb=pq[ip]->nb_node();
+      mut[ip].unlock();
+      if ( nb>0 ) return true;
+    }
+    return false;
+  }
+
+  /** Delete the best node
+   * If no node is available, the thread becomes idle : it spins while no 
+   * insertion is notified, then it parks. The method returns 0 when all 
+   * the threads are idle.
+   * The idle time of each thread is cumulated in its idle slot.
+   */
   virtual Node *Del() {
     Node *n;
-    while ((n = SearchDel()) == 0) {
-      cond.lock();
-      Wth++;
-      if (Wth >= PQInterface<Node, PriComp,Goal>::ref) {
-        Wth = 100000;
-        cond.bcast();
-        cond.unlock();
-        //printf(" All Threads are waiting \n");
-        return 0;
-      }
-      if (Wth == PQInterface<Node, PriComp,Goal>::ref-1) {
-        //printf("************* We are waiting the last thread! %d:%d/%d\n",ThrEnvProg::rank(),Wth,PQInterface<Node, PriComp,Goal>::ref);
-      }
-      //std::cout << " Wait :"<<Wth<<" "<<ThrEnvProg::rank()<<std::endl;
-      cond.wait();
-      if (Wth >= PQInterface<Node, PriComp,Goal>::ref) {
-         cond.unlock();
-         return 0;
+    if ( closed ) return 0;
+    if ( ramp && (n = RampDel()) != 0 ) return n;
+    if ( ThrReplay::replaying() ) return ReplayDel();
+    if ( (n = SearchDel()) != 0 ) return n;
+    ThrIdleSlot &sl = idle[ThrEnvProg::rank()];
+    sl.key = HUGE_VAL;
+    sl.idls = core::mTime();
+    n = IdleDel();
+    sl.idlet += core::mTime() - sl.idls;
+    sl.idls = 0;
+    // the end of the search of the thread is recorded as a deletion without node
+    if ( n==0 ) ThrReplay::end(ThrReplay::begin());
+    return n;
+  }
+  /** Write the metrics of the priority queue : the number of nodes and the
+    * idle ratio of each thread (in percent) since the previous call.
+    * The counters are read without locking the internal priority queues.
+    * @param os the std::ostream used to write the metrics
+    */
+  virtual void Metrics(std::ostream &os) {
+    long nb=0;
+    double t=core::mTime();
+    for (int i=0;i<ThrEnvProg::npq();i++ ) {
+      nb += pq[i]->getStat()->PeekNbN();
+    }
+    os << " open=" << nb << " idle=";
+    for (int i=0;i<(int)idle.size();i++ ) {
+      double s=idle[i].idls, c=idle[i].idlet;
+      if ( s!=0 ) c += t-s;
+      double r=(t>mt ? (c-midle[i])/(t-mt) : 0);
+      os << (i==0 ? "" : ",") << (int)(100*(r<0 ? 0 : (r>1 ? 1 : r))+0.5);
+      midle[i]=c;
+    }
+    mt=t;
+  }
+  /** Get the bound of the search : the minimum of the best keys of the internal 
+    * priority queues and of the keys of the nodes explored by the threads.
+    * The keys are read without lock, the bound could then be slightly out of date.
+    */
+  virtual double BestKey() {
+    double b=HUGE_VAL;
+    for (int i=0;i<ThrEnvProg::npq();i++ ) {
+      if ( pqk[i].k < b ) b=pqk[i].k;
+    }
+    for (int i=0;i<(int)idle.size();i++ ) {
+      if ( idle[i].key < b ) b=idle[i].key;
+    }
+    if ( rk.k < b ) b=rk.k;
+    return b;
+  }
+protected:
+  /** the key of a node, used for the bound of the search during the ramp-up.
+    * The ThrPQ is also used with the load balancing priority (see mpx::EnvProg),
+    * the key is then only computed if the node has one (see BoundKey).
+    */
+  static double rkey(Node *n) {
+    return BoundKey<Node, PriComp>::key(*n);
+  }
+  /** Insert nodes in the next level of the ramp-up
+    * @param nds the array of nodes to insert
+    * @param nb the number of nodes to insert
+    * @return false if the ramp-up is ended.
+    */
+  bool RampIns(Node **nds,int nb) {
+    rc.lock();
+    if ( !ramp ) {
+      rc.unlock();
+      return false;
+    }
+    for (int i=0;i<nb;i++ ) {
+      double k=rkey(nds[i]);
+      nds[i]->addRef();
+      rnext.push_back(nds[i]);
+      if ( k < rk.k ) rk.k=k;
+    }
+    rc.unlock();
+    notify();
+    return true;
+  }
+  /** Delete a node of the level expanded by the ramp-up. 
+    * When the level is exhausted, the thread waits for the other threads 
+    * that expand its nodes, and the last one goes to the next level.
+    * @return the deleted node, 0 if the ramp-up is ended.
+    */
+  Node *RampDel() {
+    int r=ThrEnvProg::rank();
+    rc.lock();
+    if ( rhold[r] ) {
+      rhold[r]=0;
+      rbusy--;
+    }
+    while ( ramp ) {
+      if ( rpos < rlvl.size() ) {
+        Node *n=rlvl[rpos++];
+        rhold[r]=1;
+        rbusy++;
+        rc.unlock();
+        idle[r].key=rkey(n);
+        n->remRef();
+        return n;
       }
-      Wth--;
-      cond.unlock();
+      if ( rbusy==0 ) RampLevel();
+      else rc.wait();
+    }
+    rc.unlock();
+    return 0;
+  }
+  /** Go to the next level of the ramp-up, rc must be locked.
+    * The ramp-up ends when the level stores enough nodes or when it is empty.
+    */
+  void RampLevel() {
+    rlvl.swap(rnext);
+    rnext.clear();
+    rpos=0;
+    double b=HUGE_VAL;
+    for (unsigned long i=0;i<rlvl.size();i++ ) {
+      double k=rkey(rlvl[i]);
+      if ( k < b ) b=k;
+    }
+    rk.k=b;
+    if ( rlvl.empty() || (long)rlvl.size() >= rtarget ) RampEnd();
+    else rlevels++;
+    rc.bcast();
+  }
+  /** End the ramp-up, rc must be locked.
+    * The remaining nodes are dealt round-robin to the internal priority queues.
+    */
+  void RampEnd() {
+    int ip=0;
+    rfront=rlvl.size()-rpos+rnext.size();
+    for (unsigned long i=rpos;i<rlvl.size();i++,ip=(ip+1)%ThrEnvProg::npq() ) {
+      RampMove(ip,rlvl[i]);
+    }
+    for (unsigned long i=0;i<rnext.size();i++,ip=(ip+1)%ThrEnvProg::npq() ) {
+      RampMove(ip,rnext[i]);
+    }
+    rlvl.clear();
+    rnext.clear();
+    rpos=0;
+    rbusy=0;
+    for (unsigned long i=0;i<rhold.size();i++ ) rhold[i]=0;
+    rk.k=HUGE_VAL;
+    rtime=core::dTime()-rt0;
+    ramp=0;
+  }
+  /** Move a node of the ramp-up to an internal priority queue.
+    * @param ip the index of the priority queue
+    * @param n the node
+    */
+  void RampMove(int ip,Node *n) {
+    mut[ip].lock();
+    pq[ip]->Ins(n);
+    upd_key(ip);
+    mut[ip].unlock();
+    n->remRef();
+  }
+  /** Delete the nodes of the ramp-up that are not needed according to the goal.
+    * @param g the goal
+    * @return the number of deleted nodes
+    */
+  int RampDelG(Goal &g) {
+    int nb=0;
+    rc.lock();
+    nb += RampDelG(g,rlvl,rpos);
+    nb += RampDelG(g,rnext,0);
+    rc.unlock();
+    return nb;
+  }
+  /** Delete the nodes of a level that are not needed according to the goal.
+    * @param g the goal
+    * @param v the nodes of the level
+    * @param from the index of the first node not yet expanded
+    * @return the number of deleted nodes
+    */
+  int RampDelG(Goal &g,std::vector<Node *> &v,unsigned long from) {
+    unsigned long j=from;
+    for (unsigned long i=from;i<v.size();i++ ) {
+      if ( g.is4Search(v[i]) ) v[j++]=v[i];
+      else if ( v[i]->remRef()==0 ) delete v[i];
     }
+    int nb=v.size()-j;
+    v.resize(j);
+    return nb;
+  }
+  /** Delete the node of the recorded run, the thread waits its turn instead
+   * of being idle. 
+   * @return the deleted node, 0 at the end of the search of the thread.
+   */
+  Node *ReplayDel() {
+    int r=ThrReplay::begin(true);
+    if ( r==ThrReplay::Done ) return 0;
+    Node *n=SearchDel();
+    ThrReplay::end(r);
     return n;
   }
+  /** update the best key of an internal priority queue, which must be locked
+    * @param ip the index of the priority queue
+    */
+  void upd_key(int ip) {
+    pqk[ip].k = pq[ip]->BestKey();
+  }
+  /** store the key of the nodes deleted by the calling thread from an internal
+    * priority queue, which must be locked : the best key of the priority queue before
+    * the deletion is a bound of the deleted nodes.
+    * @param ip the index of the priority queue
+    * @param first true if the first node is deleted by the thread, otherwise 
+    *   the key of the thread is only decreased.
+    */
+  void del_key(int ip,bool first=true) {
+    double k=pqk[ip].k;
+    ThrIdleSlot &sl = idle[ThrEnvProg::rank()];
+    if ( first || k < sl.key ) sl.key = k;
+  }
+  /** The idle loop of the Del() method.
+   * @return the deleted node, 0 if the search is ended.
+   */
+  Node *IdleDel() {
+    Node *n;
+    while ( true ) {
+      if ( idle_enter() ) return 0;
+      long seen = stamp;
+      if ( !SearchPeek() ) {
+        int sp;
+        for (sp=0; sp<ThrEnvProg::idle_spin() && stamp==seen; sp++ ) {
+          if ( Wth >= Term ) return 0;
+          sched_yield();
+        }
+        if ( stamp==seen ) park(seen);
+      }
+      if ( closed || !idle_leave() ) return 0;
+      if ( (n = SearchDel()) != 0 ) return n;
+    }
+    return 0;
+  }
+public:
   /** Method that returns the number of waiting threads
     */
   virtual int waiting_threads() {
-     cond.lock();
-     int w = Wth;
-     cond.unlock();
-     return w;
+     return Wth;
   }
   /** Method that returns the number of waiting threads
     */
@@ -791,33 +1360,46 @@ public:
   /** wake up all the waiting threads to end the search
     */
   virtual bool wake_up_for_end() {
-    cond.lock();
-    if ( Wth==PQInterface<Node, PriComp,Goal>::ref-1 ) {
-       Wth = 100000;
-       cond.bcast();
-       cond.unlock();
+    if ( __sync_bool_compare_and_swap(&Wth,PQInterface<Node, PriComp,Goal>::ref-1,(int)Term) ) {
+       wake_all();
        return true;
     }
-    cond.unlock();
     return false;
   }
+  /** Test if the search is ended : all the threads have been idle.
+    */
+  bool ended() {
+    return Wth >= Term;
+  }
+  /** Set the condition variable broadcast when the search is ended or closed,
+    * a thread that is not a search thread could then wait for the end.
+    * @param c the condition variable, 0 for none
+    */
+  void set_end_cond(ThrCond *c) {
+    ecnd = c;
+  }
+  /** End the search before the priority queue is empty, the next deletions
+    * return 0 and the pending nodes are kept until the priority queue is deleted.
+    * The threads that explore a node end after its exploration.
+    */
+  void close() {
+    closed = 1;
+    wake_all();
+  }
   /** Function for a non-computing thread waiting for the first insertion
     */
   virtual void wait_for_start() {
-    for (int i=0;i<ThrEnvProg::npq();i++ ) {
-      mut[i].lock();
-      if (pq[i]->getStat()->get_counter('i').get() != 0) {
-		  mut[i].unlock();
-		  return;
-	  }
-      mut[i].unlock();
-    }
     cond.lock();
-    cond.wait();
+    while ( !started ) cond.wait();
     cond.unlock();
   }
   virtual long nb_node() {
     long nbnd=0;
+    if ( ramp ) {
+      rc.lock();
+      nbnd += rlvl.size()-rpos+rnext.size();
+      rc.unlock();
+    }
     for (int i=0;i<ThrEnvProg::npq();i++ ) {
       mut[i].lock();
       nbnd +=pq[i]->nb_node();
@@ -834,6 +1416,183 @@ public:
   /** Ask node for Load Balencing
     */
   virtual void set_need_node4LB(int v) { Need_NodeforLB = v; }
+  /** Pack the nodes of all the internal priority queues without removing them.
+    * The internal priority queues must be locked by ckpt_begin().
+    * @param se the Serialize object
+    */
+  virtual void SnapshotNodes(Serialize &se) {
+    for (int i=0;i<ThrEnvProg::npq();i++ ) {
+      pq[i]->SnapshotNodes(se);
+    }
+  }
+  /** UnPack the nodes and distribute them among the internal priority queues
+    * @param se the DeSerialize object
+    */
+  virtual void UnPack(DeSerialize &se) {
+    Node *n;
+    int v=1,ip=0;
+    se.UnPack(&v,1);
+    while ( v ) {
+      n = new Node();
+      n->UnPack(se);
+      mut[ip].lock();
+      pq[ip]->Ins(n);
+      upd_key(ip);
+      mut[ip].unlock();
+      ip = (ip+1)%ThrEnvProg::npq();
+      se.UnPack(&v,1);
+    }
+    notify();
+  }
+  /** Method called by a thread that does not store any node when a checkpoint is requested.
+    * The thread waits until the end of the checkpoint.
+    */
+  virtual void ckpt_pause() {
+    ckc.lock();
+    paused++;
+    ckc.bcast();
+    while ( this->ckreq ) ckc.wait();
+    paused--;
+    ckc.unlock();
+  }
+  /** Begin a checkpoint.
+    * The threads are asked to pause at their next safepoint. The checkpoint 
+    * is taken when each thread that references the priority queue is 
+    * paused or idle, all the internal priority queues are then locked until ckpt_end().
+    * @return false if the search is ended, or if the threads are not paused after CkptTmo seconds.
+    */
+  virtual bool ckpt_begin() {
+    double t=core::dTime();
+    if ( ramp ) return false;
+    ckc.lock();
+    this->ckreq = 1;
+    while ( Wth < Term && core::dTime()-t < CkptTmo ) {
+      ckc.unlock();
+      lock_all();
+      cond.lock();
+      int r = PQInterface<Node, PriComp,Goal>::ref;
+      cond.unlock();
+      ckc.lock();
+      if ( Wth < Term && paused+Wth >= r ) {
+        ckc.unlock();
+        return true;
+      }
+      unlock_all();
+      ckc.timedwait(0.001);
+    }
+    this->ckreq = 0;
+    ckc.bcast();
+    ckc.unlock();
+    return false;
+  }
+  /** End a checkpoint, the internal priority queues are unlocked and 
+    * the paused threads are resumed.
+    */
+  virtual void ckpt_end() {
+    unlock_all();
+    ckc.lock();
+    this->ckreq = 0;
+    ckc.bcast();
+    ckc.unlock();
+  }
+protected:
+  /// lock all the internal priority queues
+  void lock_all() {
+    for (int i=0;i<ThrEnvProg::npq();i++ ) mut[i].lock();
+  }
+  /// unlock all the internal priority queues
+  void unlock_all() {
+    for (int i=ThrEnvProg::npq()-1;i>=0;i-- ) mut[i].unlock();
+  }
+  /** The calling thread becomes idle.
+    * @return true if the search is ended (all the threads are idle).
+    */
+  bool idle_enter() {
+    int w = __sync_add_and_fetch(&Wth,1);
+    if ( w >= Term ) return true;
+    if ( w >= PQInterface<Node, PriComp,Goal>::ref && 
+         __sync_bool_compare_and_swap(&Wth,w,(int)Term) ) {
+      wake_all();
+      return true;
+    }
+    return false;
+  }
+  /** The calling idle thread becomes active again.
+    * @return false if the search is ended.
+    */
+  bool idle_leave() {
+    while ( true ) {
+      int w = Wth;
+      if ( w >= Term ) return false;
+      if ( __sync_bool_compare_and_swap(&Wth,w,w-1) ) return true;
+    }
+  }
+  /** Park the calling thread on its idle slot.
+    * The thread is not parked if a notification arrived since 
+    * the stamp \a seen was read.
+    * @param seen the last notification stamp seen by the thread.
+    */
+  void park(long seen) {
+    ThrIdleSlot &sl = idle[ThrEnvProg::rank()];
+    sl.cond.lock();
+    sl.parked = 1;
+    __sync_synchronize();
+    while ( !sl.wake && stamp==seen && Wth < Term ) {
+      sl.cond.wait();
+    }
+    sl.parked = 0;
+    sl.wake = 0;
+    sl.cond.unlock();
+  }
+  /** Notify the idle threads that nodes have been inserted.
+    * Only one parked thread is woken up, the spinning threads see the 
+    * new stamp value.
+    */
+  void notify() {
+    if ( !started ) {
+      cond.lock();
+      started = 1;
+      cond.bcast();
+      cond.unlock();
+    }
+    __sync_synchronize();
+    if ( Wth <= 0 ) return;
+    long st = __sync_add_and_fetch(&stamp,1);
+    int nb = idle.size();
+    for (int i=0; i<nb; i++ ) {
+      ThrIdleSlot &sl = idle[(st+i)%nb];
+      if ( sl.parked && !sl.wake ) {
+        sl.cond.lock();
+        if ( sl.parked && !sl.wake ) {
+          sl.wake = 1;
+          sl.cond.signal();
+          sl.cond.unlock();
+          return;
+        }
+        sl.cond.unlock();
+      }
+    }
+  }
+  /** Wake up all the parked threads at the end of the search.
+    */
+  void wake_all() {
+    __sync_add_and_fetch(&stamp,1);
+    for (unsigned int i=0; i<idle.size(); i++ ) {
+      idle[i].cond.lock();
+      idle[i].cond.signal();
+      idle[i].cond.unlock();
+    }
+    cond.lock();
+    started = 1;
+    cond.bcast();
+    cond.unlock();
+    if ( ecnd!=0 ) {
+      ecnd->lock();
+      ecnd->bcast();
+      ecnd->unlock();
+    }
+  }
+public:
   /// Prints the statistics and contents
   virtual ostream &Prt(ostream &os = std::cout) const {
     pq[0]->getStat()->display_title(os);
@@ -842,6 +1601,9 @@ public:
       mut[i].display(os);pq[i]->getStat()->display_data(os);
     }
     cond.display(os);
+    if ( rtarget>0 ) {
+      os << "Ramp-up : "<<rlevels<<" levels expanded, "<<rfront<<" nodes in the frontier, "<<rtime<<" s\n";
+    }
     return os;
   }
   /// Prints the statistics and contents
@@ -903,14 +1665,39 @@ class ThrAlgoEnvProg : public AlgoEnvProg<Trait> {
   typedef ThrGoal<Trait> TheThrGoal;
   typedef AlgoEnvProg<Trait> aep;
 
-private:
+protected:
+  /// the barrier of the end of the search
   ThrBarrier thb;
+private:
   TheInstance **thinst;
   TheStat **st;
   TheStat *cumul_st;
   PQInterface<TheNode,ThePriComp,TheGoal> *thpq;
   bool local_alloc_pq;
   bool local_alloc_goal;
+  TheInstance *ckinst;
+  pthread_t ckth;
+  ThrCond ckcond;
+  volatile int ckrun;
+  long ckepoch;
+  SerialBuf ckbuf;
+  pthread_t mth;
+  ThrCond mcond;
+  volatile int mrun;
+  Metrics_out mout;
+  double mlt, mln, mt0;
+  /// the magic number and the version of the checkpoint files
+  enum { CkptMagic=0x426f6243, CkptVersion=2 };
+  /// the function executed by the checkpoint thread
+  static void *ckpt_thread(void *a) {
+    ((ThrAlgoEnvProg *)a)->ckpt_loop();
+    return 0;
+  }
+  /// the function executed by the metrics thread
+  static void *metrics_thread(void *a) {
+    ((ThrAlgoEnvProg *)a)->metrics_loop();
+    return 0;
+  }
 protected:
   /// the array of algorithm objects
   TheAlgo **pal;
@@ -978,6 +1765,7 @@ protected:
         cumul_st->merge(*(pal[i]->getStat()));
       }
       cumul_st->display_data(std::cout);
+      if (core::disp_histo()) cumul_st->display_histo(std::cout);
       thpq->Prt(std::cout);
       thrgoal->display_stat(std::cout);
     }
@@ -1023,7 +1811,183 @@ protected:
     if ( local_alloc_pq ) delete thpq;
   }
 
+  /** Pack the header of a checkpoint file
+    * @param ser the Serialize object.
+    */
+  virtual void Pack_Header(Serialize &ser) {
+    int h[2]={CkptMagic,CkptVersion};
+    ser.Pack(h,2);
+    ser.Pack(&ckepoch,1);
+  }
+  /** UnPack the header of a checkpoint file
+    * @param ser the DeSerialize object.
+    * @return false if the file is not a checkpoint file of this version.
+    */
+  virtual bool UnPack_Header(DeSerialize &ser) {
+    int h[2]={0,0};
+    ser.UnPack(h,2);
+    if ( h[0]!=CkptMagic || h[1]!=CkptVersion ) return false;
+    ser.UnPack(&ckepoch,1);
+    return true;
+  }
+  /** Take a checkpoint of the search without stopping it.
+    * The algorithms are paused at their next safepoint (see PQInterface::ckpt_begin()),
+    * the state of the search is packed in memory, then the algorithms are resumed
+    * before the file is written. The file is replaced only when the new one is 
+    * complete.
+    * @return true if the checkpoint has been written.
+    */
+  virtual bool checkpoint() {
+#ifdef BOBPP_ENABLE_FT
+    double t=core::dTime();
+    if ( !thpq->ckpt_begin() ) return false;
+    TheStat cs(*(ckinst->id()));
+    ckepoch++;
+    ckbuf.reset();
+    Pack_Header(ckbuf);
+    ckinst->Pack(ckbuf);
+    thrgoal->Pack(ckbuf);
+    thpq->Snapshot(ckbuf);
+    for (int i = 0 ; i < ThrEnvProg::n_algo_thread() ; i++) {
+      cs.merge(*(st[i]));
+    }
+    cs.Pack(ckbuf);
+    thpq->ckpt_end();
+    double tp=core::dTime()-t;
+    if ( !ckbuf.write_atomic(core::opt().SVal("--","-ft_file")) ) {
+       std::cout << "ThrEnvProg : could not write the checkpoint "<<core::opt().SVal("--","-ft_file")<<"\n"; 
+       return false;
+    }
+    if ( core::isVerb() ) {
+      std::cout << "ThrEnvProg : checkpoint "<<ckepoch<<" ("<<ckbuf.size()<<" bytes, pause "<<tp<<"s, total "<<core::dTime()-t<<"s)\n";
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+  /** the loop of the checkpoint thread, a checkpoint is taken every -- -ft_period seconds.
+    */
+  virtual void ckpt_loop() {
+    double per=core::get_ft_period();
+    double next=core::dTime()+per;
+    ckcond.lock();
+    while ( ckrun ) {
+      if ( core::dTime() < next ) {
+        ckcond.timedwait(next-core::dTime());
+        continue;
+      }
+      ckcond.unlock();
+      checkpoint();
+      ckcond.lock();
+      next=core::dTime()+per;
+    }
+    ckcond.unlock();
+  }
+  /// start the checkpoint thread if the -- -ft_period option is set.
+  void ckpt_start() {
+#ifdef BOBPP_ENABLE_FT
+    if ( ckinst!=0 && core::get_ft_period()>0 && AlgoEnvProg<Trait>::Level()==0 ) {
+      ckrun=1;
+      if ( pthread_create(&ckth, 0, ckpt_thread, (void *)this)!=0 ) ckrun=0;
+    }
+#endif
+  }
+  /// stop the checkpoint thread.
+  void ckpt_stop() {
+    if ( !ckrun ) return;
+    ckcond.lock();
+    ckrun=0;
+    ckcond.bcast();
+    ckcond.unlock();
+    pthread_join(ckth, NULL);
+  }
+  /** Write a line of metrics : the time, the number of explored nodes and the
+    * number of nodes per second since the previous line, the metrics of the priority 
+    * queue (see PQInterface::Metrics()) and of the goal, the bound and the gap of the search
+    * (see PQInterface::BestKey()), the estimated size of the tree with the progress and
+    * the remaining time of the search (see TreeProfile), and the resident memory in Kbytes.
+    * The statistics of the threads are read without synchronization.
+    * @param os the std::ostream used to write the line
+    */
+  virtual void metrics_line(std::ostream &os) {
+    double t=core::dTime(), nn=0;
+    TreeProfile tp;
+    for (int i = 0 ; i < ThrEnvProg::n_algo_thread() ; i++) {
+      nn += st[i]->peek_timer('C');
+      if ( st[i]->profile()!=0 ) tp.merge(*st[i]->profile());
+    }
+    os << "t=" << t << " nodes=" << (long long)nn << " nps=" << (long long)(t>mlt ? (nn-mln)/(t-mlt) : 0);
+    metrics_pq(os);
+    thrgoal->Metrics(os);
+    thrgoal->MetricsBound(os,thpq->BestKey());
+    tp.Metrics(os,t-mt0);
+    os << " rss=" << core::rss() << "\n";
+    mlt=t;
+    mln=nn;
+  }
+  /** Write the metrics of the priority queue in a line of metrics.
+    * @param os the std::ostream used to write the line
+    */
+  virtual void metrics_pq(std::ostream &os) {
+    thpq->Metrics(os);
+  }
+  /** the loop of the metrics thread, a line is written every -- -mp seconds.
+    */
+  virtual void metrics_loop() {
+    double per=core::get_metrics_period();
+    double next=core::dTime()+per;
+    mcond.lock();
+    while ( mrun ) {
+      if ( core::dTime() < next ) {
+        mcond.timedwait(next-core::dTime());
+        continue;
+      }
+      mcond.unlock();
+      std::ostringstream os;
+      metrics_line(os);
+      mout.write(os.str());
+      mcond.lock();
+      next+=per;
+    }
+    mcond.unlock();
+  }
+  /// start the metrics thread if the -- -mf option is set.
+  void metrics_start() {
+    if ( core::get_metrics_file().empty() || AlgoEnvProg<Trait>::Level()!=0 ) return;
+    if ( !mout.open(core::get_metrics_file(),core::get_metrics_rot()) ) {
+      std::cout << "ThrEnvProg : could not open the metrics destination "<<core::get_metrics_file()<<"\n";
+      return;
+    }
+    mlt=mt0=core::dTime();
+    mln=0;
+    mrun=1;
+    if ( pthread_create(&mth, 0, metrics_thread, (void *)this)!=0 ) mrun=0;
+  }
+  /// stop the metrics thread, a last line is written.
+  void metrics_stop() {
+    if ( !mrun ) return;
+    mcond.lock();
+    mrun=0;
+    mcond.bcast();
+    mcond.unlock();
+    pthread_join(mth, NULL);
+    std::ostringstream os;
+    metrics_line(os);
+    mout.write(os.str());
+    mout.close();
+  }
+  /** start the ramp-up of the search if the --thr -ru option is set.
+    * The ramp-up is not used with one thread, with the local dive (-- -ld) 
+    * and when the search is recorded or replayed (--thr -rec/-rep).
+    */
+  void ramp_start() {
+    if ( ThrEnvProg::ramp_up()<=0 || ThrEnvProg::n_algo_thread()<2 ) return;
+    if ( core::get_local_dive()!=0 || ThrReplay::active() ) return;
+    ((TheThrPQ *)thpq)->ramp_up((long)ThrEnvProg::ramp_up()*ThrEnvProg::n_algo_thread());
+  }
   /** Method to initialize the search from a file.
+    * The nodes are distributed among the priority queues of the threads.
     * @param inst the instance
     * @param _thpq the priority queue where restoring the nodes.
     * @param _thrgoal the goal where restoring the solutions or related Goal's datas.
@@ -1032,12 +1996,15 @@ protected:
 #ifdef BOBPP_ENABLE_FT
     if ( core::opt().BVal("--","-ft_rs") && AlgoEnvProg<Trait>::Level()==0 ) {
       std::cout << "ThrEnvProg : Restoring Data\n"; 
-      DeSerialFile fti(core::opt().SVal("--","-ft_file"));
+      DeSerialMap fti(core::opt().SVal("--","-ft_file"));
       if ( !fti.is_open() ) {
          std::cout << "EnvProg : File "<<core::opt().SVal("--","-ft_file")<<" not found (exit)\n"; 
          exit(1);
       }
-
+      if ( !UnPack_Header(fti) ) {
+         std::cout << "ThrEnvProg : File "<<core::opt().SVal("--","-ft_file")<<" is not a checkpoint file (exit)\n"; 
+         exit(1);
+      }
       inst->UnPack(fti);
       Alloc(inst,_thpq,_thrgoal);
       thrgoal->UnPack(fti);
@@ -1046,7 +2013,7 @@ protected:
       fti.close();
       thrgoal->set_verbosity(BaseAlgoEnvProg::isdisp_goal());
       //al = new TheAlgo(inst, pq, tg, st);
-      std::cout << "ThrEnvProg : Data are restored\n"; 
+      std::cout << "ThrEnvProg : Data are restored (checkpoint "<<ckepoch<<")\n"; 
       return true;
     }
 #endif
@@ -1059,12 +2026,16 @@ protected:
 #ifdef BOBPP_ENABLE_FT
     if (pal[0]->isEtStop() && AlgoEnvProg<Trait>::state_is_save()==0  && AlgoEnvProg<Trait>::Level()==0 ) {
       std::cout << "ThrEnvProg : algo is stopped, save data\n"; 
-      SerialFile fto(core::opt().SVal("--","-ft_file"));
+      SerialBuf fto;
+      ckepoch++;
+      Pack_Header(fto);
       inst->Pack(fto);
       thrgoal->Pack(fto);
       thpq->Pack(fto);
       cumul_st->Pack(fto);
-      fto.close();
+      if ( !fto.write_atomic(core::opt().SVal("--","-ft_file")) ) {
+         std::cout << "ThrEnvProg : could not write the file "<<core::opt().SVal("--","-ft_file")<<"\n"; 
+      }
       std::cout << "EnvProg : Data are saved\n"; 
       return true;
     }
@@ -1081,11 +2052,13 @@ protected:
    */
   virtual void init(TheNode *nd, TheInstance *inst,bool is_master=true,PQInterface<TheNode,ThePriComp,TheGoal> *_thpq=0, TheThrGoal *_thrgoal=0) {
     if ( is_master ) {
+      ckinst = inst;
       if ( !init_from_file(inst) ) {
         init_instance(inst);
         Alloc(inst,_thpq,_thrgoal);
         thrgoal->Init(inst);
         thrgoal->set_verbosity(BaseAlgoEnvProg::isdisp_goal());
+        if ( local_alloc_pq ) ramp_start();
         if (nd == 0) inst->InitAlgo(pal[0]);
         else pal[0]->GPQIns(nd);
       }
@@ -1103,11 +2076,15 @@ protected:
     for (int i = 0 ; i < ThrEnvProg::n_algo_thread() ; i++) {
       ThrEnvProg::run(i, pal[i], &thb);
     }
+    ckpt_start();
+    metrics_start();
   }
   /** Method that run the master thread.
     */
   virtual void run_master() {
     thb.Wait();
+    ckpt_stop();
+    metrics_stop();
   }
   /** Master thread will wait the Algorithm barrier.
     */
@@ -1152,7 +2129,7 @@ public:
     * @param _v a flag to indicate if the algorithm will dispaly the statistics and/or the solution
     * @param _l the level where this Environment will be used.
     */
-  ThrAlgoEnvProg(int _v=BaseAlgoEnvProg::disp_default(),int _l=0) : AlgoEnvProg<Trait>(_v,_l),thb() {
+  ThrAlgoEnvProg(int _v=BaseAlgoEnvProg::disp_default(),int _l=0) : AlgoEnvProg<Trait>(_v,_l),thb(),ckinst(0),ckcond(),ckrun(0),ckepoch(0),ckbuf(),mcond(),mrun(0),mout(),mlt(0),mln(0),mt0(0) {
   }
   /** the destructor
     */
@@ -1232,6 +2209,48 @@ protected:
   virtual void init_instance(TheInstance *inst) {inst->Init(); }
 };
 
+/** The Threaded Algorithms Wrapper for Branch and Bound with a memory bounded open list.
+ * The internal priority queues are PQSpill, they store at most -- -spm nodes in memory
+ * and the other ones in files (see @ref SpillPQGRP).
+ */
+template<class Trait>
+class ThrBBSpillAlgoEnvProg : public ThrAlgoEnvProg<Trait,BestEPri<typename Trait::Node>,PQSpillLB> {
+public:
+  /// The type of the instance given by the Trait class (template).
+  typedef typename Trait::Instance TheInstance;
+  /// the constructor
+  ThrBBSpillAlgoEnvProg() : ThrAlgoEnvProg<Trait,BestEPri<typename Trait::Node>,PQSpillLB >() {
+  }
+  /// Destructor
+  virtual ~ThrBBSpillAlgoEnvProg() {}
+protected:
+  /** Initialize the instance.
+    * @param inst the instance to initialize
+    */
+  virtual void init_instance(TheInstance *inst) {inst->Init(); }
+};
+
+/** The Threaded Algorithms Wrapper for Branch and Bound with a compact open list.
+ * The internal priority queues are PQCompact, they store at most -- -cpm unpacked nodes 
+ * and the other ones in their packed form (see @ref SpillPQGRP).
+ */
+template<class Trait>
+class ThrBBCompactAlgoEnvProg : public ThrAlgoEnvProg<Trait,BestEPri<typename Trait::Node>,PQCompactLB> {
+public:
+  /// The type of the instance given by the Trait class (template).
+  typedef typename Trait::Instance TheInstance;
+  /// the constructor
+  ThrBBCompactAlgoEnvProg() : ThrAlgoEnvProg<Trait,BestEPri<typename Trait::Node>,PQCompactLB >() {
+  }
+  /// Destructor
+  virtual ~ThrBBCompactAlgoEnvProg() {}
+protected:
+  /** Initialize the instance.
+    * @param inst the instance to initialize
+    */
+  virtual void init_instance(TheInstance *inst) {inst->Init(); }
+};
+
 /** The Threaded Algorithms Wrapper for simple Divide and Conquer.
  */
 template<class Trait>
@@ -1323,6 +2342,151 @@ protected:
   virtual void init_instance(TheInstance *inst) {inst->Init(); }
 };
 
+/** The Threaded Algorithms Wrapper for a portfolio of two strategies.
+ * The threads are split in two groups (see the --thr -pf option), each group
+ * searches the whole tree from its own copy of the root node with its own 
+ * priority queue, ordered by Pri1 for the first group and by Pri2 for the
+ * second one. The two groups share the same ThrGoal, then a solution found
+ * by one strategy prunes the nodes of the other one. As soon as one strategy
+ * has explored its tree, the priority queue of the other one is closed (see 
+ * ThrPQ::close()) and the search is ended.
+ * A GenChild could also choose its heuristics with ThrEnvProg::strategy().
+ *
+ * The portfolio uses one internal priority queue per strategy (--thr -d 1), 
+ * it could not be recorded or replayed, and it does not take checkpoints.
+ */
+template<class Trait,class Pri1,class Pri2,class ThePriLB=BestEPri<typename Trait::Node>,
+         template <class Node,class PriComp,class PriLB, class Goal> class SPQ=PQLB>
+class ThrPortfolioAlgoEnvProg : public ThrAlgoEnvProg<Trait,ThePriLB,SPQ> {
+public:
+  /// The type of the instance given by the Trait class (template).
+  typedef typename Trait::Instance TheInstance;
+  typedef typename Trait::Node TheNode;
+  typedef typename Trait::Algo TheAlgo;
+  typedef typename Trait::Goal TheGoal;
+  typedef typename Trait::PriComp ThePriComp;
+  typedef ThrGoal<Trait> TheThrGoal;
+  typedef ThrAlgoEnvProg<Trait,ThePriLB,SPQ> TheThrAlgoEnvProg;
+  /// the priority queue of the first strategy
+  typedef ThrPQ<TheNode, ThePriComp, TheGoal, SPQ<TheNode, Pri1, ThePriLB, TheGoal> > ThePQ1;
+  /// the priority queue of the second strategy
+  typedef ThrPQ<TheNode, ThePriComp, TheGoal, SPQ<TheNode, Pri2, ThePriLB, TheGoal> > ThePQ2;
+private:
+  ThePQ1 *pq1;
+  ThePQ2 *pq2;
+  ThrCond rcond;
+  /// the strategy that has ended first, -1 if the search has been stopped
+  int win;
+  /// the time when the first strategy has ended
+  double wtime;
+protected:
+  /** Allocate the two priority queues, the algorithms of the threads of 
+    * the second strategy use the second one.
+    * @param inst the instance
+    * @param _thpq not used
+    * @param _thrgoal the optional goal 
+    */
+  virtual void Alloc(TheInstance *inst, PQInterface<TheNode,ThePriComp,TheGoal> *_thpq=0, TheThrGoal *_thrgoal=0) {
+    if ( ThrEnvProg::npq()!=1 || ThrReplay::active() ) {
+      std::cerr << "--thr -d, -rec and -rep are not available with the portfolio environment\n";
+      exit(1);
+    }
+    pq1 = new ThePQ1(*(inst->id()),true);
+    pq2 = new ThePQ2(*(inst->id()),true);
+    pq1->set_end_cond(&rcond);
+    pq2->set_end_cond(&rcond);
+    TheThrAlgoEnvProg::Alloc(inst,pq1,_thrgoal);
+    for (int i = ThrEnvProg::portfolio_split(); i < ThrEnvProg::n_algo_thread(); i++) {
+      TheAlgo *a = new TheAlgo((TheInstance *)this->pal[i]->getInstance(), pq2, this->thrgoal, this->pal[i]->getStat());
+      BOBASSERT(a != 0, Exception, "Threaded Env", "Algo allocation failed");
+      delete this->pal[i];
+      this->pal[i] = a;
+    }
+  }
+  /** Method to Free all the object allocated in the Alloc Method.
+    */
+  virtual void Free() {
+    TheThrAlgoEnvProg::Free();
+    delete pq1;
+    delete pq2;
+  }
+  /** init the search, the root node is inserted in the two priority queues.
+   * @param nd the node to explore from.
+   * @param inst the instance associated with the search.
+   * @param is_master true for the main process.
+   * @param _thpq not used
+   * @param _thrgoal the optional goal 
+   */
+  virtual void init(TheNode *nd, TheInstance *inst,bool is_master=true,PQInterface<TheNode,ThePriComp,TheGoal> *_thpq=0, TheThrGoal *_thrgoal=0) {
+    int s = ThrEnvProg::portfolio_split();
+    TheThrAlgoEnvProg::init(nd,inst,is_master,_thpq,_thrgoal);
+    if ( !is_master || s >= ThrEnvProg::n_algo_thread() ) return;
+    if ( nd == 0 ) inst->InitAlgo(this->pal[s]);
+    else this->pal[s]->GPQIns(new TheNode(nd));
+  }
+  /** The master thread waits for the end of a strategy, then it closes
+    * the priority queue of the other one. The two priority queues broadcast
+    * rcond when their search is ended.
+    */
+  virtual void run_master() {
+    double t=core::dTime();
+    win = -1;
+    rcond.lock();
+    while ( win < 0 ) {
+      if ( pq1->ended() ) win = 0;
+      else if ( pq2->ended() ) win = 1;
+      else rcond.wait();
+    }
+    rcond.unlock();
+    wtime = core::dTime()-t;
+    if ( win == 0 ) pq2->close();
+    if ( win == 1 ) pq1->close();
+    TheThrAlgoEnvProg::run_master();
+  }
+  /** Write the metrics of the two priority queues in a line of metrics.
+    * @param os the std::ostream used to write the line
+    */
+  virtual void metrics_pq(std::ostream &os) {
+    os << " pq1";
+    pq1->Metrics(os);
+    os << " pq2";
+    pq2->Metrics(os);
+  }
+  /** Display the statistics of the two priority queues and the winner strategy
+    */
+  virtual void display_stat() {
+    TheThrAlgoEnvProg::display_stat();
+    if ((AlgoEnvProg<Trait>::isdisp()&2) == 2) {
+      pq2->Prt(std::cout);
+      if ( win >= 0 ) {
+        std::cout << "Portfolio : the strategy "<<win+1<<" has ended first after "<<wtime<<" s\n";
+      }
+    }
+  }
+  /// the search is not restored from a checkpoint
+  virtual bool init_from_file(TheInstance *inst,PQInterface<TheNode,ThePriComp,TheGoal> *_thpq=0, TheThrGoal *_thrgoal=0) {
+    return false;
+  }
+  /// the state of the search is not saved
+  virtual bool save_on_file(TheInstance *inst) {
+    return false;
+  }
+  /// no checkpoint is taken
+  virtual bool checkpoint() {
+    return false;
+  }
+  /** Initialize the instance.
+    * @param inst the instance to initialize
+    */
+  virtual void init_instance(TheInstance *inst) {inst->Init(); }
+public:
+  /// the constructor
+  ThrPortfolioAlgoEnvProg() : TheThrAlgoEnvProg(),pq1(0),pq2(0),rcond(),win(-1),wtime(0) {
+  }
+  /// Destructor
+  virtual ~ThrPortfolioAlgoEnvProg() {}
+};
+
 /**
  * @}
  */
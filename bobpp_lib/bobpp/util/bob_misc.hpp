@@ -33,6 +33,7 @@
 #define BOBMISCHEADER
 
 #include<vector>
+#include<cstring>
 
 namespace Bob {
 
@@ -85,10 +86,7 @@ public:
     DBGAFF_PCK("pvector::Pack", "Pack a pvector");
     const int s = std::vector<T>::size();
     Bob::Pack(bs, &s, 1);
-    for (int i = 0;i < s;i++) {
-      const T *v = &((*this)[i]);
-      Bob::Pack(bs, v);
-    }
+    if (s > 0) Bob::PackArray(bs, &((*this)[0]), s);
   }
   /** Pack method to serialize the pvector  
     * @param bs the Bob::DeSerialize object use to unpack the pvector object
@@ -98,10 +96,7 @@ public:
     int s;
     Bob::UnPack(bs, &s, 1);
     std::vector<T>::resize(s);
-    for (int i = 0;i < s;i++) {
-      T *v = &((*this)[i]);
-      Bob::UnPack(bs, v);
-    }
+    if (s > 0) Bob::UnPackArray(bs, &((*this)[0]), s);
   }
 };
 
@@ -262,16 +257,16 @@ public:
   }
   /** get the last fixed facility at the beginning of the permutation
     */
-  int getFacR() { if ( r>0 ) return j2i[r-1]; else return -1; }
+  int getFacR() const { if ( r>0 ) return j2i[r-1]; else return -1; }
   /** get the last fixed location at the beginning of the permutation
     */
-  int getLocR() { if ( r>0 ) return r-1; else return -1; }
+  int getLocR() const { if ( r>0 ) return r-1; else return -1; }
   /** get the last fixed facility at the beginning of the permutation
     */
-  int getFacD() { if ( d<nb-1 ) return j2i[d+1]; else return -1; }
+  int getFacD() const { if ( d<nb-1 ) return j2i[d+1]; else return -1; }
   /** get the last fixed location at the beginning of the permutation
     */
-  int getLocD() { if ( d<nb-1 ) return d+1; else return -1; }
+  int getLocD() const { if ( d<nb-1 ) return d+1; else return -1; }
 
   /** Assign a facilty i to the location j
     * @param i facility to put on the j location
@@ -388,6 +383,305 @@ public:
 
 };
 
+/** Type of the indices stored by a CPermutation
+ * \ingroup BOB_UTIL_GRP
+ * The indices are stored in an unsigned short.
+ */
+template <bool Small>
+struct cperm_index {
+  /// type of the index
+  typedef unsigned short type;
+};
+
+/** Type of the indices stored by a small CPermutation
+ * \ingroup BOB_UTIL_GRP
+ * The indices are stored in an unsigned char.
+ */
+template <>
+struct cperm_index<true> {
+  /// type of the index
+  typedef unsigned char type;
+};
+
+/** Compact Permutation class
+ * \ingroup BOB_UTIL_GRP
+ * This class has the same interface as the Bob::Permutation class, but the
+ * permutation is stored inline in the object : the i2j and j2i arrays have a fixed
+ * capacity MaxS and use unsigned char indices (MaxS<255) or unsigned short indices.
+ * Copying a CPermutation does not allocate memory, and only the used part of the arrays
+ * is copied, thus a node that stores a CPermutation is smaller and faster to copy.
+ * The free facilities are also stored in a bitset, the firstFree() and nextFree()
+ * methods iterate over the free facilities without testing all of them :
+ * @code
+ * for (int i=p.firstFree(); i!=-1 ; i=p.nextFree(i) ) { ... }
+ * @endcode
+ * The get_i2j() and get_j2i() methods are not available.
+ * @param MaxS the maximum size of the permutation (less than 65535).
+ */
+template <int MaxS>
+class CPermutation {
+public:
+  /// type of the stored indices
+  typedef typename cperm_index<(MaxS < 255)>::type Idx;
+  enum { NoIdx = (MaxS < 255 ? 0xff : 0xffff), /*!< value of a non assigned index */
+         NbW = (MaxS + 63) / 64 /*!< number of words of the bitset */
+       };
+protected:
+  /// size of the permutation
+  int nb;
+  /// number of free locations
+  int nbfree;
+  int r, /*!< indice of the first free locations */
+      d; /*!< indice of the last free locations */
+  /// array giving the location from the facility
+  Idx i2j[MaxS];
+  /// array giving the facilty from the location
+  Idx j2i[MaxS];
+  /// bitset of the free facilities
+  unsigned long long fr[NbW];
+
+  /// the number of words of the bitset used by the permutation
+  int nbw() const {
+    return (nb + 63) / 64;
+  }
+  /// Pack an array of indices
+  static void pack_idx(Bob::Serialize &bs, const unsigned char *t, int n) {
+    bs.Pack((const char *)t, n);
+  }
+  /// Pack an array of indices
+  static void pack_idx(Bob::Serialize &bs, const unsigned short *t, int n) {
+    bs.Pack(t, n);
+  }
+  /// UnPack an array of indices
+  static void unpack_idx(Bob::DeSerialize &bs, unsigned char *t, int n) {
+    bs.UnPack((char *)t, n);
+  }
+  /// UnPack an array of indices
+  static void unpack_idx(Bob::DeSerialize &bs, unsigned short *t, int n) {
+    bs.UnPack(t, n);
+  }
+  /// compute the bitset of the free facilities
+  void set_free() {
+    for (int w = 0; w < NbW; w++) fr[w] = 0;
+    for (int i = 0; i < nb; i++) {
+      if (i2j[i] == NoIdx) fr[i >> 6] |= (1ULL << (i & 63));
+    }
+  }
+public:
+  /** Constructor
+    */
+  CPermutation() : nb(0), nbfree(0), r(0), d(0) {
+    set_free();
+  }
+  /** Constructor
+    * @param s the size of the permutation
+    */
+  CPermutation(int s) {
+    init(s);
+  }
+  /** Constructor
+    * @param p the permutation to copy
+    */
+  CPermutation(const CPermutation &p) {
+    copy(p);
+  }
+  /** copy method
+   * @param p the permutation to copy
+   */
+  void copy(const CPermutation &p)  {
+    nb = p.nb;
+    nbfree = p.nbfree;
+    r = p.r;
+    d = p.d;
+    memcpy(i2j, p.i2j, nb * sizeof(Idx));
+    memcpy(j2i, p.j2i, nb * sizeof(Idx));
+    memcpy(fr, p.fr, NbW * sizeof(unsigned long long));
+  }
+  /** assignment operator
+   * @param p the permutation to copy
+   */
+  CPermutation &operator=(const CPermutation &p) {
+    if (this != &p) copy(p);
+    return *this;
+  }
+  /** size of the permutation
+    */
+  int size() const {
+    return nb;
+  }
+  /** Method to initialize the permutation object
+    * each facility is non assigned and each location is free.
+    * @param s the size of the permutation
+    */
+  void init(int s) {
+    BOBASSERT(s <= MaxS, UserException, "CPermutation::init", "size greater than the capacity");
+    nbfree = nb = s;
+    r = 0;
+    d = nb - 1;
+    memset(i2j, 0xff, nb * sizeof(Idx));
+    memset(j2i, 0xff, nb * sizeof(Idx));
+    for (int w = 0; w < NbW; w++) fr[w] = 0;
+    for (int w = 0; w < nb / 64; w++) fr[w] = ~0ULL;
+    if (nb & 63) fr[nb >> 6] = (1ULL << (nb & 63)) - 1;
+  }
+  /** Assign a facility i on the next free location
+    * @param i the facility to put on the nex free location
+    */
+  void fixeR(int i) {
+    fixe(i, r);
+    r++;
+  }
+  /** Assign a facility i on the last free location
+    * @param i the facilty to put on the last free location
+    */
+  void fixeD(int i) {
+    fixe(i, d);
+    d--;
+  }
+  /** get the last fixed facility at the beginning of the permutation
+    */
+  int getFacR() const { if ( r>0 ) return geti(r-1); else return -1; }
+  /** get the last fixed location at the beginning of the permutation
+    */
+  int getLocR() const { if ( r>0 ) return r-1; else return -1; }
+  /** get the last fixed facility at the beginning of the permutation
+    */
+  int getFacD() const { if ( d<nb-1 ) return geti(d+1); else return -1; }
+  /** get the last fixed location at the beginning of the permutation
+    */
+  int getLocD() const { if ( d<nb-1 ) return d+1; else return -1; }
+
+  /** Assign a facilty i to the location j
+    * @param i facility to put on the j location
+    * @param j the location
+    */
+  void fixe(int i, int j) {
+    i2j[i] = (Idx)j;
+    j2i[j] = (Idx)i;
+    fr[i >> 6] &= ~(1ULL << (i & 63));
+    nbfree--;
+  }
+  /** get the facility at the given location
+    * @param j the location
+    * @return the facility, -1 if the location is free
+    */
+  int geti(int j) const {
+    return (j2i[j] == NoIdx ? -1 : j2i[j]);
+  }
+  /** get the assigned location of a facilty
+    * @param i the facility
+    * @return the location assigned to the facility, -1 if tha facility is not assigned
+    */
+  int getj(int i) const {
+    return (i2j[i] == NoIdx ? -1 : i2j[i]);
+  }
+  /** get the number of free facilities/locations.
+    * @return int number of free location.
+    */
+  int nbFree() const {
+    return nbfree;
+  }
+  /** test if the facility is assigned.
+    * @param i the facility to test.
+    * @return true if the facility is assigned.
+    */
+  bool isfixed(int i) const {
+    return i2j[i] != NoIdx;
+  }
+  /** test if the facility is not assign, is free.
+    * @param i the facility to test.
+    * @return true if the facility is free.
+    */
+  bool isfree(int i) const {
+    return i2j[i] == NoIdx;
+  }
+  /** test if the location is free.
+    * @param j the location to test.
+    * @return true if the location is not free.
+    */
+  bool isaffect(int j) const { return j2i[j]!=NoIdx; }
+  /** Test if this possible to fixe on the last location.
+    * @return true a location is free.
+    */
+  bool fixeOnR() const {
+    return r <= (nb - 1 - d);
+  }
+  /** test there exists free locations/values
+    * @return true if each value has been fixed
+    */
+  bool isallfixed() const {
+    return nbfree == 0;
+  }
+  /** get the first free facility
+    * @return the first free facility, -1 if there is no free facility
+    */
+  int firstFree() const {
+    for (int w = 0; w < nbw(); w++) {
+      if (fr[w] != 0) return (w << 6) + __builtin_ctzll(fr[w]);
+    }
+    return -1;
+  }
+  /** get the next free facility
+    * @param i a facility
+    * @return the first free facility greater than i, -1 if there is no such facility
+    */
+  int nextFree(int i) const {
+    i++;
+    int w = i >> 6;
+    if (w >= nbw()) return -1;
+    unsigned long long m = ((i & 63) == 0 ? fr[w] : fr[w] & (~0ULL << (i & 63)));
+    while (m == 0) {
+      if (++w >= nbw()) return -1;
+      m = fr[w];
+    }
+    return (w << 6) + __builtin_ctzll(m);
+  }
+  /** Display a Permutation
+    * @param os the ostream used to display.
+    */
+  ostream &Prt(ostream &os) const {
+    os << "values    :";
+    for (int i = 0;i < nb;i++) {
+      os << geti(i) << ",";
+    }
+    os << std::endl;
+    os << "locations :";
+    for (int i = 0;i < nb;i++) {
+      os << getj(i) << ",";
+    }
+    os << std::endl;
+    return os;
+  }
+  /** Pack method to serialize the permutation
+    * @param bs the Serialize object
+    */
+  void Pack(Bob::Serialize &bs)  const {
+    DBGAFF_PCK("CPermutation::Pack", "Pack a permutation");
+    bs.Pack(&nb, 1);
+    bs.Pack(&nbfree, 1);
+    bs.Pack(&r, 1);
+    bs.Pack(&d, 1);
+    pack_idx(bs, i2j, nb);
+    pack_idx(bs, j2i, nb);
+  }
+  /** Unpack method to deserialize the permutation
+    * @param bs the DeSerialize object
+    */
+  void UnPack(Bob::DeSerialize &bs)  {
+    DBGAFF_PCK("CPermutation::UnPack", "UnPack a permutation");
+    bs.UnPack(&nb, 1);
+    bs.UnPack(&nbfree, 1);
+    bs.UnPack(&r, 1);
+    bs.UnPack(&d, 1);
+    // a corrupt or mismatched stream must not overflow the inline arrays
+    if (nb < 0 || nb > MaxS) BOBEXCEPTION(IOException, "CPermutation::UnPack", "size greater than the capacity");
+    unpack_idx(bs, i2j, nb);
+    unpack_idx(bs, j2i, nb);
+    set_free();
+  }
+
+};
+
 }
 
 #endif
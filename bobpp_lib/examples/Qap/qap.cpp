@@ -1047,6 +1047,11 @@ int main(int n, char ** v) {
   Bob::AthaBBAlgoEnvProg<QAPTrait> env;
   Bob::AthaEnvProg::init(n, v);
   Bob::core::Config(n, v);
+#elif defined(Portfolio)
+  Bob::ThrPortfolioAlgoEnvProg<QAPTrait,Bob::DepthEPri<QAPNode>,Bob::BestEPri<QAPNode> > env;
+  Bob::ThrEnvProg::init();
+  Bob::core::Config(n, v);
+  Bob::ThrEnvProg::start();
 #elif defined(Threaded)
   Bob::ThrBBAlgoEnvProg<QAPTrait> env;
   Bob::ThrEnvProg::init();
@@ -17,6 +17,9 @@
 
 #define NMAX 30
 
+/// the permutation stored by the nodes
+typedef Bob::CPermutation<NMAX> APVNSPerm;
+
 class APVNSInstance;
 class APVNSNode;
 class APVNSGenChild;
@@ -65,12 +68,12 @@ struct APVNSOption {
 
 class APVNSNode : public Bob::VNSIntMinNode {
   public:
-    Bob::Permutation p;
+    APVNSPerm p;
     Bob::pvector<int> ci;
     Bob::pvector<int> cj;
     APVNSNode() : Bob::VNSIntMinNode(),p(),ci(),cj() { }
     APVNSNode(const APVNSInstance &hi,int i=0);
-    APVNSNode(const APVNSInstance &inst,Bob::Permutation &_p);
+    APVNSNode(const APVNSInstance &inst,APVNSPerm &_p);
     virtual ostream &Prt(ostream &os=std::cout) const {
       Bob::VNSIntMinNode::Prt(os);
       p.Prt(os);
@@ -147,7 +150,7 @@ APVNSNode::APVNSNode(const APVNSInstance &inst,int i) : Bob::VNSIntMinNode(),p(i
   setCost(c);
   set_ls(1);
 }
-APVNSNode::APVNSNode(const APVNSInstance &inst,Bob::Permutation &_p) : Bob::VNSIntMinNode(),p(_p),ci(inst.size()),cj(inst.size()) {
+APVNSNode::APVNSNode(const APVNSInstance &inst,APVNSPerm &_p) : Bob::VNSIntMinNode(),p(_p),ci(inst.size()),cj(inst.size()) {
   int c=0;
   for (int i=0;i<inst.size();i++ ) {
      ci[i]=0;
@@ -258,7 +261,7 @@ class Move2Opt : public Bob::Move<APVNSTrait> {
    int jx = g->p.getj(imax);
    for (int i=0;i<inst->size();i++ ) {
      if ( i!=imax) {
-       Bob::Permutation np(g->p);
+       APVNSPerm np(g->p);
        int jt = np.getj(i);
        np.fixe(imax,jt);
        np.fixe(i,jx);
@@ -283,7 +286,7 @@ class Move2Opt : public Bob::Move<APVNSTrait> {
    if (ix == imax ) return fl;
    for (int j=0;j<inst->size();j++ ) {
      if ( j!=jmax) {
-       Bob::Permutation np(g->p);
+       APVNSPerm np(g->p);
        int it = np.geti(j);
        if ( it==imax ) continue;
        np.fixe(it,jmax);
@@ -315,7 +318,7 @@ class MoveR2Opt : public Bob::Move<APVNSTrait> {
       i2 = rand()%inst->size();
       j2 = g->p.getj(i2);
     } while ( i1==i2 );
-    Bob::Permutation np(g->p);
+    APVNSPerm np(g->p);
     np.fixe(i1,j2);
     np.fixe(i2,j1);
     APVNSNode *f=new APVNSNode(*inst,np);
@@ -349,7 +352,7 @@ class Move3Opt : public Bob::Move<APVNSTrait> {
     } while ( i3==i1 || i3==i2 );
     j3 = g->p.getj(i3);
 
-    Bob::Permutation np(g->p);
+    APVNSPerm np(g->p);
     np.fixe(i1,j2);
     np.fixe(i2,j3);
     np.fixe(i3,j1);
@@ -389,7 +392,7 @@ class Move4Opt : public Bob::Move<APVNSTrait> {
     } while ( i4==i1 || i4==i2 || i4==i3);
     j4 = g->p.getj(i4);
 
-    Bob::Permutation np(g->p);
+    APVNSPerm np(g->p);
     np.fixe(i1,j2);
     np.fixe(i2,j3);
     np.fixe(i3,j4);
@@ -29,6 +29,9 @@ public:
     MyNode(int n, int s) : Bob::BBIntMinNode(n), seed(s) {
         DBGAFF_USER("MyNode::MyNode(Eval)", "Called");
     }
+    MyNode(MyNode *n) : Bob::BBIntMinNode(n), seed(n->seed) {
+        DBGAFF_USER("MyNode::MyNode(MyNode *)", "Called");
+    }
     virtual ~MyNode() {
         DBGAFF_USER("MyNode::~MyNode", "Called");
     }
@@ -131,8 +134,11 @@ public:
             int r = rand_r(&seed);
             int v = 1 + (int)((float)(step) * ((float)r / (RAND_MAX + 1.0)));
 
-            printf("%d %d %u %d %d\n", n->getEval(), i, r, v, step);
+            //printf("%d %d %u %d %d\n", n->getEval(), i, r, v, step);
             MyNode *ns = new MyNode(n->getEval() + v, seed);
+            // the depth is used by the subtree size load metric (--mpx -lm st)
+            // and by the estimator of the size of the tree (-- -mf)
+            ns->dist() = n->dist() + 1;
             //std::cout <<"Alloc Son "<<i<<" : "<<n->getEval()<<std::endl;
             algo->start_eval(ns,n);
             algo->end_eval(ns);
@@ -144,14 +150,34 @@ public:
 };
 
 
+/** Solve the instance with a given load balancing strategy and topology
+  */
+template<template<class TraitB,class Topos, class PQ, class Goal,class Loads> class Strat, class Topo>
+void solve(MyInstance *Instance) {
+    Bob::mpx::BBAlgoEnvProg<MyTrait,Strat,Topo,long> env;
+    env(Instance);
+}
+
+/** Solve the instance with a given load balancing strategy
+  * the topology is chosen by the --mpx -topo option
+  */
+template<template<class TraitB,class Topos, class PQ, class Goal,class Loads> class Strat>
+void solve(MyInstance *Instance, const std::string &topo) {
+    if ( topo == "ring" ) solve<Strat,Bob::mpx::topo_ring>(Instance);
+    else if ( topo == "tree" ) solve<Strat,Bob::mpx::topo_tree>(Instance);
+    else if ( topo == "hc" ) solve<Strat,Bob::mpx::topo_hypercube>(Instance);
+    else solve<Strat,Bob::mpx::topo_a2a>(Instance);
+}
+
 int main(int n, char ** v) {
 
     Bob::core::opt().add(std::string("--bb"), Bob::Property("-lb", "Initial Value for the root node", 0));
     Bob::core::opt().add(std::string("--bb"), Bob::Property("-ub", "Initial Value for the Solution", 20));
     Bob::core::opt().add(std::string("--bb"), Bob::Property("-st", "Maximum Step to increase the evaluation of a son node", 4));
     Bob::core::opt().add(std::string("--bb"), Bob::Property("-ns", "Number of sons", 2));
+    Bob::core::opt().add(std::string("--mpx"), Bob::Property("-lb", "load balancing strategy (2t=two thresholds, ws=work stealing)", "2t"));
+    Bob::core::opt().add(std::string("--mpx"), Bob::Property("-topo", "topology (a2a=all to all, ring, tree, hc=hypercube)", "a2a"));
     Bob::mpx::EnvProg::init(n, v);
-    Bob::mpx::BBAlgoEnvProg<MyTrait,Bob::mpx::lb_strat_2t,Bob::mpx::topo_a2a,long> env;
     Bob::core::Config(n, v);
     Bob::mpx::EnvProg::start();
     MyProblem mp();
@@ -164,7 +190,9 @@ int main(int n, char ** v) {
 
     // Solve the instance i.e. all the tree
     std::cout << "-------- Start to solve the entire tree" << std::endl;
-    env(Instance);
+    std::string topo = Bob::core::opt().SVal("--mpx", "-topo");
+    if ( Bob::core::opt().SVal("--mpx", "-lb") == "ws" ) solve<Bob::mpx::lb_strat_ws>(Instance, topo);
+    else solve<Bob::mpx::lb_strat_2t>(Instance, topo);
     /* Alloc one algo.
      * lance le Init de Instance
      * lance le () de l'algo
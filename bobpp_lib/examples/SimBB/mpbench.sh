@@ -0,0 +1,33 @@
+#!/bin/sh
+# ==========================================================================
+# Benchmark of the load balancing strategies and of the topologies of the
+# Bob++ MPx environment on the simulated Branch and Bound (bbmpi).
+# usage : mpbench.sh [nb_process] [bbmpi options]
+# example : mpbench.sh 8 --bb -ub 44 --thr -n 1
+# For each strategy and each topology, the script prints the wall clock
+# time of the slowest process and the total number of explored nodes,
+# which must be the same for all the runs.
+# With SHM=1, the shared memory version (bbshm) is run instead of bbmpi,
+# the processes are forked by the program itself and mpirun is not used.
+# ==========================================================================
+
+NP=${1:-4}
+[ $# -gt 0 ] && shift
+OPTS=${*:---bb -ub 40 --thr -n 1}
+MPIRUN=${MPIRUN:-mpirun --oversubscribe}
+if [ -n "$SHM" ]; then
+  RUN="./bbshm --shm -np $NP"
+else
+  RUN="$MPIRUN -np $NP ./bbmpi"
+fi
+
+printf "%-4s %-6s %10s %10s\n" lb topo time nodes
+for lb in 2t ws; do
+  for topo in a2a ring tree hc; do
+    $RUN $OPTS --mpx -lb $lb -topo $topo 2>&1 | awk -v lb=$lb -v topo=$topo '
+      # the statistics of all the processes are gathered by the process 0, one line per thread
+      /^ *[0-9]+, *[0-9]+\|/ { split($0, a, "|"); split(a[2], c, ":"); s += c[1] }
+      /Core Time/ { split($0, a, ":"); if (a[2] > t) t = a[2] }
+      END { printf "%-4s %-6s %10.3f %10d\n", lb, topo, t, s }'
+  done
+done
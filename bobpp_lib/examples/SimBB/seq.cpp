@@ -27,6 +27,9 @@ public:
     MyNode(int n, int s) : Bob::BBIntMinNode(n), seed(s) {
         DBGAFF_USER("MyNode::MyNode(Eval)", "Called");
     }
+    MyNode(MyNode *n) : Bob::BBIntMinNode(n), seed(n->seed) {
+        DBGAFF_USER("MyNode::MyNode(MyNode *)", "Called");
+    }
     virtual ~MyNode() {
         DBGAFF_USER("MyNode::~MyNode", "Called");
     }
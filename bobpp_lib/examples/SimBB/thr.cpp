@@ -28,6 +28,9 @@ public:
     MyNode(int n, int s) : Bob::BBIntMinNode(n), seed(s) {
         DBGAFF_USER("MyNode::MyNode(Eval)", "Called");
     }
+    MyNode(MyNode *n) : Bob::BBIntMinNode(n), seed(n->seed) {
+        DBGAFF_USER("MyNode::MyNode(MyNode *)", "Called");
+    }
     virtual ~MyNode() {
         DBGAFF_USER("MyNode::~MyNode", "Called");
     }
@@ -104,6 +107,8 @@ public:
 
             //printf("%d %d %u %d %d\n", n->getEval(), i, r, v, step);
             MyNode *ns = new MyNode(n->getEval() + v, seed);
+            // the depth is used by the estimator of the size of the tree (-- -mf)
+            ns->dist() = n->dist() + 1;
             //std::cout <<"Alloc Son "<<i<<" : "<<n->getEval()<<std::endl;
             algo->start_eval(ns,n);
             algo->end_eval(ns);
@@ -0,0 +1,100 @@
+
+#include<bobpp/bobpp>
+
+/*
+ * Checks the serialization of the CPermutation : random permutations
+ * are packed in a SerialBuf and unpacked from a DeSerialMap, the unpacked
+ * permutation must have the same fixed and free facilities.
+ * A permutation greater than the capacity of the receiver must be rejected.
+ * The program returns 1 if a check fails.
+ */
+
+/** Compares two permutations
+  * @param p the first permutation
+  * @param q the second permutation
+  * @return true if the permutations are the same
+  */
+template<class P1,class P2>
+bool same(const P1 &p,const P2 &q) {
+	if ( p.size()!=q.size() || p.nbFree()!=q.nbFree() ) return false;
+	if ( p.getLocR()!=q.getLocR() || p.getLocD()!=q.getLocD() ) return false;
+	for (int i=0;i<p.size();i++ ) {
+		if ( p.isfree(i)!=q.isfree(i) ) return false;
+		if ( p.isfixed(i) && p.getj(i)!=q.getj(i) ) return false;
+		if ( p.isaffect(i)!=q.isaffect(i) ) return false;
+		if ( p.isaffect(i) && p.geti(i)!=q.geti(i) ) return false;
+	}
+	int a=p.firstFree(),b=q.firstFree();
+	while ( a==b && a>=0 ) { a=p.nextFree(a); b=q.nextFree(b); }
+	return a==b;
+}
+
+/** Checks the round trip of random permutations
+  * @param name the name of the check
+  * @param nb the number of permutations
+  * @param sz the maximum size of the permutations
+  * @return the number of errors
+  */
+template<int MaxS>
+int check(const char *name,int nb,int sz) {
+	Bob::SerialBuf sb;
+	int err=0;
+
+	srand(1);
+	for (int k=0;k<nb;k++ ) {
+		Bob::CPermutation<MaxS> p(1+rand()%sz),q;
+		int nbf=rand()%(p.size()+1);
+		for (int l=0;l<nbf;l++ ) {
+			int i=p.firstFree();
+			for (int s=rand()%p.nbFree();s>0;s-- ) i=p.nextFree(i);
+			if ( rand()%2 ) p.fixeR(i); else p.fixeD(i);
+		}
+		sb.reset();
+		p.Pack(sb);
+		Bob::DeSerialMap ds(sb.data(),sb.size());
+		q.UnPack(ds);
+		if ( !same(p,q) || !ds.IsEmpty() ) {
+			std::cout << name << ": the permutation "<<k<<" differs"<<std::endl;
+			p.Prt(std::cout); q.Prt(std::cout);
+			err++;
+		}
+	}
+	std::cout << name << ": " << nb << " permutations, " << (err==0 ? "ok" : "FAILED") << std::endl;
+	return err;
+}
+
+/** Checks that a permutation greater than the capacity is rejected
+  * @return the number of errors
+  */
+int check_size() {
+	Bob::SerialBuf sb;
+	Bob::CPermutation<300> p(280);
+	Bob::CPermutation<100> q;
+
+	p.Pack(sb);
+	Bob::DeSerialMap ds(sb.data(),sb.size());
+	try {
+		q.UnPack(ds);
+	} catch (Bob::IOException &e) {
+		std::cout << "CPermutation capacity: ok" << std::endl;
+		return 0;
+	}
+	std::cout << "CPermutation capacity: FAILED" << std::endl;
+	return 1;
+}
+
+int main(int n, char ** v) {
+	Bob::core::opt().add(std::string("--check"),Bob::Property("-nb","number of permutations",10000));
+	Bob::core::Config(n,v);
+
+	int nb = Bob::core::opt().NVal("--check","-nb");
+	int err=0;
+	// unsigned char indices
+	err += check<50>("CPermutation<50>",nb,50);
+	// unsigned short indices
+	err += check<1000>("CPermutation<1000>",nb,1000);
+	err += check_size();
+
+	Bob::core::End();
+	return (err==0 ? 0 : 1);
+}
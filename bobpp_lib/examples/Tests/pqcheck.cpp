@@ -0,0 +1,260 @@
+
+#include<bobpp/bobpp>
+#include<set>
+
+/*
+ * Checks the priority queues against the PQHn : the same nodes are
+ * inserted (one by one and by batches), deleted and pruned in the two
+ * priority queues, the deleted nodes must have the same evaluations and
+ * the best keys and the numbers of pruned nodes must be the same.
+ * As in a Branch and Bound, the bound of the goal only decreases and the
+ * inserted nodes are always suitable for the search.
+ * The PQSpill and the PQCompact may keep pruned nodes in their runs, they
+ * are dropped when they are deleted, the total number of pruned nodes must
+ * be the same. Small caps are used to store many runs (see main).
+ * The batch deletions (DelBatch) of the PQHn, the PQSkew and the PQLB are
+ * checked against single deletions from the PQHn.
+ * The Reset of a priority queue must also reset its statistics.
+ * The program returns 1 if a priority queue fails.
+ */
+
+class MyMinNode : public Bob::BBIntMinNode {
+        public:
+                MyMinNode() : Bob::BBIntMinNode() {}
+                MyMinNode(int n) : Bob::BBIntMinNode(n) {}
+};
+
+/// The goal keeps the nodes with an evaluation lower than the bound
+template<class Node>
+class BoundGoal {
+	public:
+		long ub;
+		BoundGoal(long b) : ub(b) {}
+		bool is4Search(Node *n) const { return n->getEval() < ub; }
+};
+
+typedef Bob::BestEPri<MyMinNode> Pri;
+typedef BoundGoal<MyMinNode> Goal;
+typedef Bob::PQHn<MyMinNode,Pri,Goal> pqref;
+
+typedef Bob::PQHk<MyMinNode,Pri,Goal> pqhk;
+typedef Bob::PQBucket<MyMinNode,Pri,Goal> pqbk;
+typedef Bob::PQSpill<MyMinNode,Pri,Goal> pqsp;
+typedef Bob::PQCompact<MyMinNode,Pri,Goal> pqcp;
+
+typedef Bob::PQHn<MyMinNode,Pri,Goal,4> pqhn4;
+typedef Bob::PQSkew<MyMinNode,Pri,Goal> pqsk;
+typedef Bob::PQLB<MyMinNode,Pri,Bob::DepthPri<MyMinNode>,Goal> pqlb;
+
+/// deletes a node if it is not stored in a priority queue
+void release(MyMinNode *n) {
+	if ( n!=0 && n->isDel() ) delete n;
+}
+
+/** Deletes the best node of a priority queue, the pruned nodes are dropped
+  * @param pq the priority queue
+  * @param g the goal
+  * @param ng the number of pruned nodes
+  * @return the best node suitable for the search
+  */
+template<class PQ>
+MyMinNode *del(PQ &pq,Goal &g,long &ng) {
+	MyMinNode *b;
+	while ( (b=pq.Del())!=0 && !g.is4Search(b) ) {
+		ng++;
+		release(b);
+	}
+	return b;
+}
+
+/** Checks a priority queue against the PQHn
+  * @param name the name of the priority queue
+  * @param nb the number of operations
+  * @param es the maximum evaluation of the nodes
+  * @param lazy true if the priority queue could keep pruned nodes
+  * @return the number of errors
+  */
+template<class PQ>
+int check(const char *name,long nb,long es,bool lazy=false) {
+	pqref ref;
+	PQ pq;
+	Goal g(es);
+	MyMinNode *bt[8],*a,*b;
+	long i,nbd=0,nga=0,ngb=0;
+	int j,nbb,err=0;
+
+	srand(1);
+	for (i=0;i<nb && err<10;i++ ) {
+		int op=rand()%8;
+		if ( op<3 ) {
+			a = new MyMinNode(rand()%g.ub);
+			a->dist() = rand()%10;
+			ref.Ins(a);
+			pq.Ins(a);
+		} else if ( op<5 ) {
+			nbb = 1+rand()%8;
+			for (j=0;j<nbb;j++ ) {
+				bt[j] = new MyMinNode(rand()%g.ub);
+				bt[j]->dist() = rand()%10;
+			}
+			ref.InsBatch(bt,nbb);
+			pq.InsBatch(bt,nbb);
+		} else if ( op<7 ) {
+			a = ref.Del(0);
+			b = del(pq,g,ngb);
+			if ( (a==0)!=(b==0) || (a!=0 && a->getEval()!=b->getEval()) ) {
+				std::cout << name << ": the deleted node "<<nbd<<" differs "
+				  << (a ? a->getEval() : -1) << " " << (b ? b->getEval() : -1) <<std::endl;
+				err++;
+			}
+			nbd++;
+			release(a);
+			if ( b!=a ) release(b);
+		} else if ( rand()%50==0 ) {
+			g.ub = es/2+rand()%(g.ub-es/2+1);
+			int ca = ref.DelG(g);
+			int cb = pq.DelG(g);
+			nga += ca;
+			ngb += cb;
+			if ( lazy ? cb>ca : ca!=cb ) {
+				std::cout << name << ": DelG drops "<<cb<<" nodes instead of "<<ca<<std::endl;
+				err++;
+			}
+		}
+		// a lazy priority queue may keep pruned nodes when the reference is empty
+		if ( (!lazy || ref.BestKey()!=HUGE_VAL) && ref.BestKey()!=pq.BestKey() ) {
+			std::cout << name << ": the best key is "<<pq.BestKey()<<" instead of "<<ref.BestKey()<<std::endl;
+			err++;
+		}
+	}
+	do {
+		a = ref.Del(0);
+		b = del(pq,g,ngb);
+		if ( (a==0)!=(b==0) || (a!=0 && a->getEval()!=b->getEval()) ) {
+			std::cout << name << ": the deleted node "<<nbd<<" differs "
+			  << (a ? a->getEval() : -1) << " " << (b ? b->getEval() : -1) <<std::endl;
+			err++;
+		}
+		nbd++;
+		release(a);
+		if ( b!=a ) release(b);
+	} while ( (a!=0 || b!=0) && err<10 );
+	if ( nga!=ngb ) {
+		std::cout << name << ": "<<ngb<<" pruned nodes instead of "<<nga<<std::endl;
+		err++;
+	}
+	std::cout << name << ": " << nbd << " deleted nodes, " << (err==0 ? "ok" : "FAILED") << std::endl;
+	return err;
+}
+
+/** Checks the batch deletions of a priority queue against the single deletions of the PQHn
+  * @param name the name of the priority queue
+  * @param nb the number of operations
+  * @param es the maximum evaluation of the nodes
+  * @return the number of errors
+  */
+template<class PQ>
+int check_batch(const char *name,long nb,long es) {
+	pqref ref;
+	PQ pq;
+	MyMinNode *bt[32],*bd[32],*a;
+	long i,nbd=0;
+	int j,nbb,k,err=0;
+
+	srand(2);
+	for (i=0;i<nb && err<10;i++ ) {
+		// the priority queue grows slowly
+		int op=rand()%3;
+		if ( op<2 ) {
+			nbb = 1+rand()%16;
+			for (j=0;j<nbb;j++ ) {
+				bt[j] = new MyMinNode(rand()%es);
+				bt[j]->dist() = rand()%10;
+			}
+			ref.InsBatch(bt,nbb);
+			pq.InsBatch(bt,nbb);
+		} else {
+			std::set<MyMinNode *> del;
+			nbb = 1+rand()%32;
+			k = pq.DelBatch(bd,nbb);
+			for (j=0;j<nbb;j++ ) {
+				a = ref.Del(0);
+				if ( a==0 ) break;
+				del.insert(a);
+				if ( j>=k || a->getEval()!=bd[j]->getEval() ) {
+					std::cout << name << ": the deleted node "<<nbd<<" differs "
+					  << a->getEval() << " " << (j<k ? bd[j]->getEval() : -1) <<std::endl;
+					err++;
+				}
+				nbd++;
+			}
+			if ( j!=k ) {
+				std::cout << name << ": "<<k<<" deleted nodes instead of "<<j<<std::endl;
+				err++;
+			}
+			// the nodes deleted from the two priority queues are released once
+			del.insert(bd,bd+k);
+			for (std::set<MyMinNode *>::iterator it=del.begin();it!=del.end();++it ) release(*it);
+		}
+		if ( ref.BestKey()!=pq.BestKey() || ref.nb_node()!=pq.nb_node() ) {
+			std::cout << name << ": the best key is "<<pq.BestKey()<<" instead of "<<ref.BestKey()<<std::endl;
+			err++;
+		}
+	}
+	std::set<MyMinNode *> del;
+	while ( (k=pq.DelBatch(bd,32))>0 ) del.insert(bd,bd+k);
+	while ( (a=ref.Del(0))!=0 ) del.insert(a);
+	for (std::set<MyMinNode *>::iterator it=del.begin();it!=del.end();++it ) release(*it);
+	std::cout << name << ": " << nbd << " deleted nodes by batch, " << (err==0 ? "ok" : "FAILED") << std::endl;
+	return err;
+}
+
+/** Checks that the Reset method empties a priority queue and resets its statistics
+  * @param name the name of the priority queue
+  * @return the number of errors
+  */
+template<class PQ>
+int check_reset(const char *name) {
+	PQ pq;
+	int err=0;
+
+	for (int i=0;i<100;i++ ) pq.Ins(new MyMinNode(rand()%1000));
+	for (int i=0;i<10;i++ ) release(pq.Del());
+	pq.Reset();
+	Bob::PQStat *st=pq.getStat();
+	if ( pq.BestKey()!=HUGE_VAL || st->peek_counter('i')!=0 || st->peek_counter('d')!=0 ) {
+		std::cout << name << ": the Reset keeps "<<st->peek_counter('i')<<" insertions and "
+		  << st->peek_counter('d')<<" deletions"<<std::endl;
+		err++;
+	}
+	std::cout << name << ": Reset, " << (err==0 ? "ok" : "FAILED") << std::endl;
+	return err;
+}
+
+int main(int n, char ** v) {
+	// small caps by default for the PQSpill and the PQCompact
+	static char caps[][8] = { "--", "-spm", "64", "-cpm", "64" };
+	std::vector<char *> av(v,v+n);
+	for (int k=4;k>=0;k-- ) av.insert(av.begin()+1,caps[k]);
+	Bob::core::opt().add(std::string("--check"),Bob::Property("-nb","number of operations",100000));
+	Bob::core::opt().add(std::string("--check"),Bob::Property("-s","maximum evaluation of the nodes",1000));
+	Bob::core::Config(av.size(),&av[0]);
+
+	long nb = Bob::core::opt().NVal("--check","-nb");
+	long es = Bob::core::opt().NVal("--check","-s");
+	int err=0;
+	err += check<pqhk>("PQHk",nb,es);
+	err += check<pqbk>("PQBucket",nb,es);
+	// the keys span more buckets than the maximum, the overflow heap is used
+	err += check<pqbk>("PQBucket (wide keys)",nb,1000000000L);
+	err += check<pqsp>("PQSpill",nb,es,true);
+	err += check<pqcp>("PQCompact",nb,es,true);
+	err += check_batch<pqref>("PQHn",nb,es);
+	err += check_batch<pqhn4>("PQHn<4>",nb,es);
+	err += check_batch<pqsk>("PQSkew",nb,es);
+	err += check_batch<pqlb>("PQLB",nb,es);
+	err += check_reset<pqhk>("PQHk");
+
+	Bob::core::End();
+	return (err==0 ? 0 : 1);
+}
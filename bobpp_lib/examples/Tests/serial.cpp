@@ -0,0 +1,158 @@
+
+#include<bobpp/bobpp>
+#include<unistd.h>
+#include<stdlib.h>
+
+/*
+ * Checks the memory serializers against the file serializers : the same
+ * records are packed with a SerialFile and with a SerialBuf, the two
+ * outputs must be byte-identical. The records are then unpacked with a
+ * DeSerialFile, with a DeSerialMap on the file and with a DeSerialMap on
+ * the buffer, they must be equal to the packed records.
+ * The program returns 1 if a check fails.
+ */
+
+/// a record that uses all the ways to pack the data
+struct Rec {
+	int i;
+	long l;
+	double d;
+	bool b;
+	std::string s;
+	double t[5];
+	int v[4];
+	Bob::pvector<int> pv;
+	Bob::Permutation p;
+	Bob::CPermutation<300> cp;
+
+	Rec() : i(0),l(0),d(0.0),b(false),s(),pv(),p(),cp() {}
+	/// initializes the record with random values
+	void random() {
+		i = rand()-RAND_MAX/2;
+		l = (long)rand()*rand();
+		d = (double)rand()/7.0;
+		b = rand()%2;
+		s = std::string(rand()%20,'a'+rand()%26);
+		for (int k=0;k<5;k++ ) t[k] = (double)rand()/3.0;
+		// small and great values for the variable length integers
+		for (int k=0;k<4;k++ ) v[k] = rand()>>(rand()%31);
+		pv = Bob::pvector<int>(rand()%10,rand());
+		p = Bob::Permutation(1+rand()%30);
+		for (int k=rand()%p.size();k>0;k-- ) {
+			int f=rand()%p.size();
+			while ( p.isfixed(f) ) f=(f+1)%p.size();
+			if ( rand()%2 ) p.fixeR(f); else p.fixeD(f);
+		}
+		cp.init(1+rand()%300);
+		for (int k=rand()%cp.size();k>0;k-- ) cp.fixeR(cp.firstFree());
+	}
+	void Pack(Bob::Serialize &bs) const {
+		Bob::Pack(bs,&i,1);
+		Bob::Pack(bs,&l,1);
+		Bob::Pack(bs,&d,1);
+		Bob::Pack(bs,&b,1);
+		Bob::Pack(bs,&s,1);
+		Bob::PackArray(bs,t,5);
+		bs.PackVar(v,4);
+		bs.PackPOD(&l,1);
+		pv.Pack(bs);
+		p.Pack(bs);
+		cp.Pack(bs);
+	}
+	void UnPack(Bob::DeSerialize &bs) {
+		Bob::UnPack(bs,&i,1);
+		Bob::UnPack(bs,&l,1);
+		Bob::UnPack(bs,&d,1);
+		Bob::UnPack(bs,&b,1);
+		Bob::UnPack(bs,&s,1);
+		Bob::UnPackArray(bs,t,5);
+		bs.UnPackVar(v,4);
+		bs.UnPackPOD(&l,1);
+		pv.UnPack(bs);
+		p.UnPack(bs);
+		cp.UnPack(bs);
+	}
+	bool operator==(const Rec &r) const {
+		if ( i!=r.i || l!=r.l || d!=r.d || b!=r.b || s!=r.s ) return false;
+		for (int k=0;k<5;k++ ) if ( t[k]!=r.t[k] ) return false;
+		for (int k=0;k<4;k++ ) if ( v[k]!=r.v[k] ) return false;
+		if ( pv.size()!=r.pv.size() ) return false;
+		for (unsigned int k=0;k<pv.size();k++ ) if ( pv[k]!=r.pv[k] ) return false;
+		if ( p.size()!=r.p.size() || p.nbFree()!=r.p.nbFree() ) return false;
+		for (int k=0;k<p.size();k++ ) if ( p.geti(k)!=r.p.geti(k) || p.getj(k)!=r.p.getj(k) ) return false;
+		if ( cp.size()!=r.cp.size() || cp.nbFree()!=r.cp.nbFree() ) return false;
+		for (int k=0;k<cp.size();k++ ) if ( cp.isaffect(k) && cp.geti(k)!=r.cp.geti(k) ) return false;
+		return true;
+	}
+};
+
+/** Unpacks the records and compares them to the packed records
+  * @param name the name of the deserializer
+  * @param ds the deserializer
+  * @param recs the packed records
+  * @return the number of errors
+  */
+int check(const char *name,Bob::DeSerialize &ds,const std::vector<Rec> &recs) {
+	int err=0;
+	for (unsigned int k=0;k<recs.size() && err<10;k++ ) {
+		Rec r;
+		r.UnPack(ds);
+		if ( !(r==recs[k]) ) {
+			std::cout << name << ": the record "<<k<<" differs"<<std::endl;
+			err++;
+		}
+	}
+	std::cout << name << ": " << recs.size() << " records, " << (err==0 ? "ok" : "FAILED") << std::endl;
+	return err;
+}
+
+int main(int n, char ** v) {
+	Bob::core::opt().add(std::string("--check"),Bob::Property("-nb","number of records",10000));
+	Bob::core::Config(n,v);
+
+	int nb = Bob::core::opt().NVal("--check","-nb");
+	int err=0;
+	std::vector<Rec> recs(nb);
+	char fn[] = "/tmp/bobpp_serialXXXXXX";
+	int fd = mkstemp(fn);
+	if ( fd<0 ) { perror("mkstemp"); return 1; }
+	close(fd);
+
+	srand(1);
+	for (int k=0;k<nb;k++ ) recs[k].random();
+	// the small initial size forces the buffer to grow
+	Bob::SerialBuf sb(16);
+	{
+		Bob::SerialFile sf(fn);
+		for (int k=0;k<nb;k++ ) {
+			recs[k].Pack(sf);
+			recs[k].Pack(sb);
+		}
+	}
+	// the file written by the SerialFile must be identical to the buffer
+	{
+		std::ifstream f(fn);
+		std::string c((std::istreambuf_iterator<char>(f)),std::istreambuf_iterator<char>());
+		bool same = (c.size()==sb.size() && memcmp(sb.data(),c.data(),sb.size())==0);
+		std::cout << "SerialBuf/SerialFile: " << sb.size() << " bytes, " << (same ? "ok" : "FAILED") << std::endl;
+		if ( !same ) err++;
+	}
+	{
+		Bob::DeSerialFile df(fn);
+		err += check("DeSerialFile",df,recs);
+	}
+	{
+		Bob::DeSerialMap dm(fn);
+		err += check("DeSerialMap (file)",dm,recs);
+		if ( !dm.IsEmpty() ) { std::cout << "DeSerialMap (file): data remain" << std::endl; err++; }
+	}
+	{
+		Bob::DeSerialMap dm(sb.data(),sb.size());
+		err += check("DeSerialMap (buffer)",dm,recs);
+		if ( !dm.IsEmpty() ) { std::cout << "DeSerialMap (buffer): data remain" << std::endl; err++; }
+	}
+	unlink(fn);
+
+	Bob::core::End();
+	return (err==0 ? 0 : 1);
+}
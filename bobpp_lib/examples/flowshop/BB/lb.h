@@ -90,7 +90,7 @@ typedef Bob::pvector< Jsd > Jssd;
  */
 struct J_Order {
    Jsd lag;
-   Bob::Permutation pm;
+   PFSPerm pm;
 
    J_Order() : lag(),pm() {}
    J_Order(int n) : lag(n),pm(n) {}
@@ -158,14 +158,14 @@ void ConsDelivery(Jssd &q,const PFSInstance *pfi) {
    return id;
 }*/
 
-int getMinFree(Jsd &r,const Bob::Permutation &per) {
+int getMinFree(Jsd &r,const PFSPerm &per) {
    for (unsigned int i=0;i<r.size();i++) {
         if ( per.isfree(r[i].id) ) return i;
    }
    return -1;
 }
 
-int getMinFreeNS(Jsd &r,const Bob::Permutation &per) {
+int getMinFreeNS(Jsd &r,const PFSPerm &per) {
    int min=-1;
    for (unsigned int i=0;i<r.size();i++) {
         if ( per.isfree(r[i].id) && (min==-1 || r[min].t>r[i].t )) { min=i; }
@@ -173,18 +173,16 @@ int getMinFreeNS(Jsd &r,const Bob::Permutation &per) {
    return min;
 }
 
-int getValMinFreeNS(Jsd &r,const Bob::Permutation &per) {
+int getValMinFreeNS(Jsd &r,const PFSPerm &per) {
    int min=getMinFreeNS(r,per);
    if ( min==-1 ) { return 0; }
    return r[min].t;
 }
 
-int getpk(int m,const PFSInstance *pfi,const Bob::Permutation &per) {
+int getpk(int m,const PFSInstance *pfi,const PFSPerm &per) {
    int pm=0;
-   for (int j=0;j<pfi->nbj;j++ ) { 
-      if ( per.isfree(j) ) {
-         pm+=pfi->d[j][m];
-      }
+   for (int j=per.firstFree();j!=-1;j=per.nextFree(j) ) {
+      pm+=pfi->d[j][m];
    }
    return pm;
 }
@@ -213,14 +211,14 @@ class OneMachine {
          }
       }
    }
-   int doJacksonMi(int m, const PFSInstance *pfi, const Bob::Permutation &per, const Scheduled &md) {
+   int doJacksonMi(int m, const PFSInstance *pfi, const PFSPerm &per, const Scheduled &md) {
       int t=max(r[m][getMinFreeNS(r[m],per)].t,md.getr(m));
       Bob::pvector<int> sched(pfi->nbj);
       int nbf=per.nbFree();
       int i;
       int mint;
       int maxt=0;
-      Bob::Permutation jp(per);
+      PFSPerm jp(per);
       Jsd q(d[m]);
       
       std::sort(q.begin(),q.end(),Jd_cmpC);
@@ -253,7 +251,7 @@ class OneMachine {
       //std::cout<<"Simple Jackson for "<<m<<"="<<t<<" et "<<maxt<<std::endl;
       return t;
    }
-   int doJackson(const PFSInstance *pfi, const Bob::Permutation &per, const Scheduled &md) {
+   int doJackson(const PFSInstance *pfi, const PFSPerm &per, const Scheduled &md) {
       //std::cout <<"------- Debut Jackson One Machine evaluation---------\n";
       for (int i=0;i<pfi->nbm;i++) {
          doJacksonMi(i,pfi,per,md);
@@ -262,7 +260,7 @@ class OneMachine {
       return 0;
       
    }
-   int LB1(const PFSInstance *pfi,const Bob::Permutation &per,Scheduled &md) {
+   int LB1(const PFSInstance *pfi,const PFSPerm &per,Scheduled &md) {
       int v,vr,vd,mid,mir,p,maxk=0;
       AFFMESS(std::cout <<"------- Debut LB1 One Machine evaluation---------\n");
       AFFMESS(per.Prt(std::cout));
@@ -438,10 +436,10 @@ class TwoMachineLB5 : public TwoMachine {
          DispJdTab(d[i],nbj);
       }
    }
-   int solve(int k,int l,const PFSInstance *pfi,const Bob::Permutation &per,Scheduled &md) {
+   int solve(int k,int l,const PFSInstance *pfi,const PFSPerm &per,Scheduled &md) {
       Scheduled tm(2);
-      Bob::Permutation tp(per);
-      Bob::Permutation *pkl=&(la[k][l].pm);
+      PFSPerm tp(per);
+      PFSPerm *pkl=&(la[k][l].pm);
       tm.putr(0,max(md.getr(k),getValMinFreeNS(r[k],per)));
       tm.putr(1,max(md.getr(l),getValMinFreeNS(r[l],per)));
       //std::cout<<"Initialy : on 0:"<<tm.getr(0)<<" on 1:"<<tm.getr(1)<<std::endl;
@@ -459,7 +457,7 @@ class TwoMachineLB5 : public TwoMachine {
       AFFMESS(std::cout<<"Finally: on 0:"<<tm.getr(0)<<" on 1:"<<tm.getr(1)<<std::endl);
       return max(tm.getr(0),tm.getr(1));
    }
-   int LB5(const PFSInstance *pfi,const Bob::Permutation &per,Scheduled &md) {
+   int LB5(const PFSInstance *pfi,const PFSPerm &per,Scheduled &md) {
       int ckl=0;
       int maxk=0;
       AFFMESS(std::cout <<"------- Debut Two Machine evaluation---------\n");
@@ -50,9 +50,6 @@ PFSNode *PFSInstance::getSol() {
    PFSNode *sol=0;
    PFSNode *node;
 
-   Bob::Permutation *per; 
-   per->init(nbj);
-
    for (int i=0;i<nbm-1;i++) {
       for (int j=i+1;j<nbm;j++) {
          node = new PFSNode(this,lb2m->la[i][j].pm);
@@ -81,6 +78,10 @@ void PFSInstance::read() {
    try {
      fr >> nbj;
      fr >> nbm;
+     if ( nbj > PFS_MAXJ ) {
+       std::cerr<< "Too many jobs ("<<nbj<<"), recompile with -DPFS_MAXJ="<<nbj<<" : exit\n";
+       exit(1);
+     }
      if ( nbj != 0 ) {
        d = new int *[ nbj ];
      }
@@ -187,9 +188,13 @@ void Scheduled::FixeD(const PFSInstance &pfi, int j) {
    }
 }
 
-PFSNode::PFSNode(const PFSInstance *pi,const Bob::Permutation &per):Bob::BBIntMinNode(0),nbj(pi->nbj),nbm(pi->nbm),per(nbj),sc(nbm) { 
+#ifdef PFS_PATH
+PFSNode::PFSNode(const PFSInstance *pi,const PFSPerm &pe):Bob::BBIntMinNode(0),nbj(pi->nbj),nbm(pi->nbm),path(),sc(nbm) { 
+#else
+PFSNode::PFSNode(const PFSInstance *pi,const PFSPerm &pe):Bob::BBIntMinNode(0),nbj(pi->nbj),nbm(pi->nbm),per(nbj),sc(nbm) { 
+#endif
    for (int j=0;j<nbj;j++ ) {
-      FixeR(per.geti(j),*pi);
+      FixeR(pe.geti(j),*pi);
       dist()++;
    }
    setEval(sc.getCost());
@@ -197,9 +202,13 @@ PFSNode::PFSNode(const PFSInstance *pi,const Bob::Permutation &per):Bob::BBIntMi
 }
 
 void PFSNode::FixeR(int j,const PFSInstance &pfi) {
+#ifdef PFS_PATH
+   path.push(2*j);
+#else
    per.fixeR(j);
+#endif
    sc.FixeR(pfi,j);
-   if ( per.isallfixed() ) {
+   if ( isallfixed() ) {
       sc.fus();
       setEval(sc.getCost());
       setSol();
@@ -207,9 +216,13 @@ void PFSNode::FixeR(int j,const PFSInstance &pfi) {
 }
 
 void PFSNode::FixeD(int j,const PFSInstance &pfi) {
+#ifdef PFS_PATH
+   path.push(2*j+1);
+#else
    per.fixeD(j);
+#endif
    sc.FixeD(pfi,j);
-   if ( per.isallfixed() ) {
+   if ( isallfixed() ) {
       sc.fus();
       setEval(sc.getCost());
       setSol();
@@ -217,6 +230,14 @@ void PFSNode::FixeD(int j,const PFSInstance &pfi) {
 }
 
 void PFSNode::eval(const PFSInstance *pfi,int minCost) {
+#ifdef PFS_PATH
+   PFSPerm per;
+   perm(per);
+#endif
+   eval(pfi,minCost,per);
+}
+
+void PFSNode::eval(const PFSInstance *pfi,int minCost,const PFSPerm &per) {
    int lb1 = pfi->lb1m->LB1(pfi,per,sc);
    int lb5;
 
@@ -229,44 +250,61 @@ void PFSNode::eval(const PFSInstance *pfi,int minCost) {
 
 #if 1
 bool PFSGenChild::operator()(PFSNode *p) {
+   bool fl=false;
    std::cout << "------Debut GenChild---------------------------------------------\n";
    p->Prt(std::cout); // pfs.h row:189
-   for (int j=0;j<inst->nbj;j++) {
-      if ( p->perm().isfree(j) )  {         
-         std::cout << "------Fils "<<j<<"--------------------------------------\n";
-         PFSNode *nf=new PFSNode(p);
-         nf->FixeR(j,*inst);
-         if ( nf->isSol() ) {
-            std::cout << "***********Solution :"<<nf->getEval()<<std::endl;
-            nf->Prt(std::cout);
-         } else {
-            // algo->StEval();
-            // algo->getStat()->ev_start();
-            nf->eval(inst,algo->getGoal()->getBest());
-            // algo->getStat()->ev_end();
-            std::cout << " Generate:"<<j<<" on "<<nf->dist()<<std::endl; // nf->dist is location index
-            nf->Prt(std::cout);
-            nf->dist()++;
-         }
-         algo->Search(nf);
-      } 
+#ifdef PFS_PATH
+   // the permutation of the parent is built once, the one of the child is only used by the evaluation
+   PFSPerm pe,pc;
+   p->perm(pe);
+#else
+   const PFSPerm &pe=p->perm();
+#endif
+   for (int j=pe.firstFree();j!=-1;j=pe.nextFree(j) ) {
+      std::cout << "------Fils "<<j<<"--------------------------------------\n";
+      PFSNode *nf=new PFSNode(p);
+      nf->FixeR(j,*inst);
+      if ( nf->isSol() ) {
+         std::cout << "***********Solution :"<<nf->getEval()<<std::endl;
+         nf->Prt(std::cout);
+      } else {
+         // algo->StEval();
+         // algo->getStat()->ev_start();
+#ifdef PFS_PATH
+         pc.copy(pe);
+         pc.fixeR(j);
+         nf->eval(inst,algo->getGoal()->getBest(),pc);
+#else
+         nf->eval(inst,algo->getGoal()->getBest());
+#endif
+         // algo->getStat()->ev_end();
+         std::cout << " Generate:"<<j<<" on "<<nf->dist()<<std::endl; // nf->dist is location index
+         nf->Prt(std::cout);
+         nf->dist()++;
+      }
+      fl = algo->Search(nf) || fl;
    }
    std::cout << "------Fin GenChild---------------------------------------------\n";
+   return fl;
 }
 #else
 bool PFSGenChild::operator()(PFSNode *p) {
    bool fl=false;
    PFSNode *nf;
+#ifdef PFS_PATH
+   PFSPerm pe;
+   p->perm(pe);
+#else
+   const PFSPerm &pe=p->perm();
+#endif
    AFFMESS(std::cout << "------Debut GenChild---------------------------------------------\n");
    AFFMESS(p->Prt(std::cout));
-   if ( p->perm().nbFree()==2 ) {
+   if ( pe.nbFree()==2 ) {
       int i1=-1,i2=-1;
-      for (int j=0;j<inst->nbj;j++ ) {
-         if ( p->perm().isfree(j) ) {
-            if ( i1==-1 )  i1=j;
-            else if ( i1!=-1 && i2==-1 )  i2=j;
-            else std::cout <<"strange\n";
-         }
+      for (int j=pe.firstFree();j!=-1;j=pe.nextFree(j) ) {
+         if ( i1==-1 )  i1=j;
+         else if ( i1!=-1 && i2==-1 )  i2=j;
+         else std::cout <<"strange\n";
       }
       nf=new PFSNode(p);
       nf->FixeR(i1,*inst);
@@ -282,47 +320,43 @@ bool PFSGenChild::operator()(PFSNode *p) {
       fl +=Search(nf) || fl;
       return fl;
    }
-   if ( p->perm().fixeOnR() ) {
-      for (int j=0;j<inst->nbj;j++ ) {
-         if ( p->perm().isfree(j) )  {
-            AFFMESS(std::cout << "------Fils R"<<j<<"--------------------------------------\n");
-            int ir = p->dist()+1-Bob::core::get_depth_rec();
-            if ( ir>=0 ) {
-              nf = get_rec_node(ir);
-              if ( nf==0 ) {
-                 nf = new PFSNode(p); 
-                 declare_as_rec(nf,ir);
-              }  
-              nf->copy(p);
-              nf->addRef();
-            } else {
+   if ( pe.fixeOnR() ) {
+      for (int j=pe.firstFree();j!=-1;j=pe.nextFree(j) ) {
+         AFFMESS(std::cout << "------Fils R"<<j<<"--------------------------------------\n");
+         int ir = p->dist()+1-Bob::core::get_depth_rec();
+         if ( ir>=0 ) {
+           nf = get_rec_node(ir);
+           if ( nf==0 ) {
               nf = new PFSNode(p); 
-            }
-            nf->FixeR(j,*inst);
-            algo->start_eval(nf,p);
-
-            nf->eval(inst,algo->getGoal()->getBest());
-            algo->end_eval(nf);
-            AFFMESS(std::cout << " Generate:"<<j<<" on IN"<<std::endl);
-            AFFMESS(nf->Prt(std::cout));
-            nf->dist()++;
-            fl +=Search(nf);
+              declare_as_rec(nf,ir);
+           }  
+           nf->copy(p);
+           nf->addRef();
+         } else {
+           nf = new PFSNode(p); 
          }
+         nf->FixeR(j,*inst);
+         algo->start_eval(nf,p);
+
+         nf->eval(inst,algo->getGoal()->getBest());
+         algo->end_eval(nf);
+         AFFMESS(std::cout << " Generate:"<<j<<" on IN"<<std::endl);
+         AFFMESS(nf->Prt(std::cout));
+         nf->dist()++;
+         fl +=Search(nf);
       } 
    } else {
-      for (int j=0;j<inst->nbj;j++ ) {
-         if ( p->perm().isfree(j) )  {
-            AFFMESS(std::cout << "------Fils D"<<j<<"--------------------------------------\n");
-            nf=new PFSNode(p);
-            nf->FixeD(j,*inst);
-            algo->start_eval(nf,p);
-            nf->eval(inst,algo->getGoal()->getBest());
-            algo->end_eval(nf);
-            AFFMESS(std::cout << " Generate:"<<j<<" on OUT"<<std::endl);
-            AFFMESS(nf->Prt(std::cout));
-            nf->dist()++;
-            fl +=Search(nf);
-         } 
+      for (int j=pe.firstFree();j!=-1;j=pe.nextFree(j) ) {
+         AFFMESS(std::cout << "------Fils D"<<j<<"--------------------------------------\n");
+         nf=new PFSNode(p);
+         nf->FixeD(j,*inst);
+         algo->start_eval(nf,p);
+         nf->eval(inst,algo->getGoal()->getBest());
+         algo->end_eval(nf);
+         AFFMESS(std::cout << " Generate:"<<j<<" on OUT"<<std::endl);
+         AFFMESS(nf->Prt(std::cout));
+         nf->dist()++;
+         fl +=Search(nf);
       }
    }
    AFFMESS(std::cout << "------Fin GenChild---------------------------------------------\n");
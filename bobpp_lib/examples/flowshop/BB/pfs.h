@@ -58,6 +58,13 @@ A Branch and bound is used to exactly solve some quite large instances.
 */
 
 
+#ifndef PFS_MAXJ
+/// the maximum number of jobs of an instance
+#define PFS_MAXJ 200
+#endif
+/// the permutation of the jobs stored in a node
+typedef Bob::CPermutation<PFS_MAXJ> PFSPerm;
+
 class PFSInstance;
 class PFSNode;
 class PFSGenChild;
@@ -109,6 +116,17 @@ public:
          r.UnPack(bs);
          d.UnPack(bs);
       }
+      /// Pack method used by the compact priority queue (the size is stored by the node)
+      void PackQ(Bob::Serialize &bs)  const {
+         bs.PackVar(&r[0],r.size());
+         bs.PackVar(&d[0],d.size());
+      }
+      /// Unpack method used by the compact priority queue
+      void UnPackQ(Bob::DeSerialize &bs,int n)  {
+         r.resize(n); d.resize(n);
+         bs.UnPackVar(&r[0],n);
+         bs.UnPackVar(&d[0],n);
+      }
       void FixeR(const PFSInstance &pfi, int i);
       void FixeD(const PFSInstance &pfi, int i);
       /// Display the Machine Date
@@ -122,14 +140,38 @@ public:
 };
 
 /** the Node of the search
+ * When the example is compiled with -DPFS_PATH (the pfspath program), the node does
+ * not store the permutation but only the path of the jobs fixed since the root node
+ * (see Bob::NodePath) : the decision 2*j fixes the job j on the next free location,
+ * 2*j+1 on the last free location. The open nodes of the best first search then share
+ * their ancestors, and the permutation is built when the node is expanded.
  */
 class PFSNode : public Bob::BBIntMinNode {
 protected:
 int nbj;
 int nbm;
-Bob::Permutation per;
+#ifdef PFS_PATH
+Bob::NodePath<short> path;
+#else
+PFSPerm per;
+#endif
 Scheduled sc;
 public:
+#ifdef PFS_PATH
+    /// Contructor
+    PFSNode() : Bob::BBIntMinNode(),nbj(0),nbm(0),path(),sc() { }
+    /// Contructor
+    PFSNode(int _nbj,int _nbm) : Bob::BBIntMinNode(0),nbj(_nbj),nbm(_nbm),path(),sc(_nbm) { 
+    }
+    /// Contructor
+    PFSNode(int _nbj,int _nbm,int cost) : Bob::BBIntMinNode(cost),nbj(_nbj),nbm(_nbm),path(),sc(_nbm) { 
+    }
+    PFSNode(const PFSNode &p) : Bob::BBIntMinNode(p),nbj(p.nbj),nbm(p.nbm),path(p.path),sc(p.sc) {
+    }
+    /// Contructor
+    PFSNode(PFSNode *p) : Bob::BBIntMinNode(*p),nbj(p->nbj),nbm(p->nbm),path(p->path),sc(p->sc) { 
+    }
+#else
     /// Contructor
     PFSNode() : Bob::BBIntMinNode(),nbj(0),nbm(0),per(),sc() { }
     /// Contructor
@@ -143,8 +185,9 @@ public:
     /// Contructor
     PFSNode(PFSNode *p) : Bob::BBIntMinNode(*p),nbj(p->nbj),nbm(p->nbm),per(p->per),sc(p->sc) { 
     }
+#endif
     /// Contructor
-    PFSNode(const PFSInstance *pi,const Bob::Permutation &per);
+    PFSNode(const PFSInstance *pi,const PFSPerm &per);
     /// Fixe the job i on the next free location
     void FixeR(int i,const PFSInstance &pfi);
     /// Fixe the job i on the last free location
@@ -157,11 +200,31 @@ public:
       Bob::BBIntMinNode::copy(pn);
       nbj= pn.nbj;
       nbm= pn.nbm;
+#ifdef PFS_PATH
+      path.copy(pn.path);
+#else
       per.copy(pn.per);
+#endif
       sc.copy(pn.sc);
     }
+#ifdef PFS_PATH
+    /// build the permutation from the path
+    void perm(PFSPerm &pe) const {
+       short t[PFS_MAXJ];
+       int n=path.get(t);
+       pe.init(nbj);
+       for (int i=0;i<n;i++) {
+          if ( t[i]&1 ) pe.fixeD(t[i]>>1); else pe.fixeR(t[i]>>1);
+       }
+    }
+    /// test if all the jobs are fixed
+    bool isallfixed() const { return path.size()==nbj; }
+#else
     /// get the permutation
-    Bob::Permutation &perm() { return per; }
+    PFSPerm &perm() { return per; }
+    /// test if all the jobs are fixed
+    bool isallfixed() const { return per.isallfixed(); }
+#endif
     /// get the Scheduled 
     Scheduled &sched() { return sc; }
     /// Pack method to serialize the BobNode
@@ -170,7 +233,11 @@ public:
 	    Bob::BBIntMinNode::Pack(bs);
        Bob::Pack(bs,&nbj,1);
        Bob::Pack(bs,&nbm,1);
+#ifdef PFS_PATH
+       path.Pack(bs);
+#else
        Bob::Pack(bs,&per);
+#endif
        Bob::Pack(bs,&sc);
     }
     /// Unpack method to deserialize the BobNode
@@ -179,14 +246,87 @@ public:
 	    Bob::BBIntMinNode::UnPack(bs);
        Bob::UnPack(bs,&nbj,1);
        Bob::UnPack(bs,&nbm,1);
+#ifdef PFS_PATH
+       path.UnPack(bs);
+#else
        Bob::UnPack(bs,&per);
+#endif
        Bob::UnPack(bs,&sc);
     }
+#ifdef PFS_PATH
+    /** Pack method used by the compact priority queue (see Bob::PQCompact).
+      * The decisions of the path are stored with a variable width, the unpacked
+      * path is not shared.
+      */
+    virtual void PackQ(Bob::Serialize &bs)  const {
+       int n = path.size();
+       int h[6] = { d, b, getEval(), nbj, nbm, n };
+       short t[PFS_MAXJ];
+       int j[PFS_MAXJ];
+       bs.PackVar(h,6);
+       bs.Pack(&nid,1);
+       path.get(t);
+       for (int i=0;i<n;i++) j[i] = t[i];
+       bs.PackVar(j,n);
+       sc.PackQ(bs);
+    }
+    /// Unpack method used by the compact priority queue
+    virtual void UnPackQ(Bob::DeSerialize &bs)  {
+       int h[6];
+       int j[PFS_MAXJ];
+       bs.UnPackVar(h,6);
+       bs.UnPack(&nid,1);
+       _ref = 0; d = h[0]; b = h[1]; setEval(h[2]); nbj = h[3]; nbm = h[4];
+       bs.UnPackVar(j,h[5]);
+       path = Bob::NodePath<short>();
+       for (int i=0;i<h[5];i++) path.push(j[i]);
+       sc.UnPackQ(bs,nbm);
+    }
+#else
+    /** Pack method used by the compact priority queue (see Bob::PQCompact).
+      * Only the jobs fixed at the beginning and at the end of the permutation are stored
+      * and the integers are stored with a variable width.
+      */
+    virtual void PackQ(Bob::Serialize &bs)  const {
+       int nr = per.getLocR()+1, nd = (per.getLocD()<0 ? 0 : nbj-per.getLocD());
+       int h[7] = { d, b, getEval(), nbj, nbm, nr, nd };
+       int j[PFS_MAXJ];
+       bs.PackVar(h,7);
+       bs.Pack(&nid,1);
+       for (int i=0;i<nr;i++) j[i] = per.geti(i);
+       for (int i=0;i<nd;i++) j[nr+i] = per.geti(nbj-1-i);
+       bs.PackVar(j,nr+nd);
+       sc.PackQ(bs);
+    }
+    /// Unpack method used by the compact priority queue
+    virtual void UnPackQ(Bob::DeSerialize &bs)  {
+       int h[7];
+       int j[PFS_MAXJ];
+       bs.UnPackVar(h,7);
+       bs.UnPack(&nid,1);
+       _ref = 0; d = h[0]; b = h[1]; setEval(h[2]); nbj = h[3]; nbm = h[4];
+       bs.UnPackVar(j,h[5]+h[6]);
+       per.init(nbj);
+       for (int i=0;i<h[5];i++) per.fixeR(j[i]);
+       for (int i=0;i<h[6];i++) per.fixeD(j[h[5]+i]);
+       sc.UnPackQ(bs,nbm);
+    }
+#endif
 
     /// evaluate the node
     void eval(const PFSInstance *pfi,int minCost);
+    /** evaluate the node
+      * @param pfi the instance
+      * @param minCost the cost of the best solution
+      * @param pe the permutation of the node
+      */
+    void eval(const PFSInstance *pfi,int minCost,const PFSPerm &pe);
     /// Display a PFS Node
     virtual ostream &Prt(ostream &os) const {
+#ifdef PFS_PATH
+        PFSPerm per;
+        perm(per);
+#endif
         if ( isPb() ) {
            os << "["<<getEval()<<"]\n ";
            per.Prt(os);
@@ -204,7 +344,14 @@ public:
       Bob::BBIntMinNode::log_space(st);
       if ( dist()==0 ) { st<<",\"root\""; }
       else {
+#ifdef PFS_PATH
+        PFSPerm per;
+        perm(per);
+        if ( per.fixeOnR() ) 
+#else
         if ( perm().fixeOnR() ) 
+#endif
+
            st <<",\""<<per.getFacD()<<","<<per.getLocD()<<"\"";
         else 
            st <<",\""<<per.getFacR()<<","<<per.getLocR()<<"\"";
@@ -42,6 +42,10 @@ void PFSInstance::read() {
 	try {
 		fr >> nbj;
 		fr >> nbm;
+		if ( nbj > PFS_MAXJ ) {
+			std::cerr<< "Too many jobs ("<<nbj<<"), recompile with -DPFS_MAXJ="<<nbj<<" : exit\n";
+			exit(1);
+		}
 				
 		if ( nbj != 0 ) {
 			jc= new unsigned long[ nbj ];
@@ -89,33 +93,31 @@ void PFSNode::Fixe(int j,const PFSInstance &pfi) {
 
 bool PFSGenChild::operator()(PFSNode *p) {
    bool fl = false;
-   for (int j=0;j<inst->nbj;j++ ) {
-      if ( p->perm().isfree(j) )  {
-         PFSNode *nf; 
-         int ir = p->dist()+1-Bob::core::get_depth_rec();
-         if ( ir>=0 ) {
-            //std::cout<<pthread_self()<<"   Rec node "<<p->dist()+1<<":"<<ir<<"\n";
-            nf = get_rec_node(ir);
-            if ( nf==0 ) {
-               nf = new PFSNode(p); 
-               declare_as_rec(nf,ir);
-               //std::cout<<pthread_self()<<"  Declare node:"<<ir<<"\n";
-            }  
-            nf->copy(p);
-            nf->addRef();
-         } else {
+   for (int j=p->perm().firstFree();j!=-1;j=p->perm().nextFree(j) ) {
+      PFSNode *nf; 
+      int ir = p->dist()+1-Bob::core::get_depth_rec();
+      if ( ir>=0 ) {
+         //std::cout<<pthread_self()<<"   Rec node "<<p->dist()+1<<":"<<ir<<"\n";
+         nf = get_rec_node(ir);
+         if ( nf==0 ) {
             nf = new PFSNode(p); 
-         }
-
-         nf->Fixe(j,*inst);
-         if ( nf->perm().isallfixed() ) {
-            nf->setSol();
-            //std::cout << "Solution :"<<nf->getCost()<<std::endl;
-            //nf->Prt(std::cout);
-         }
-         nf->dist()++;
-         fl+=Search(nf);
-      } 
+            declare_as_rec(nf,ir);
+            //std::cout<<pthread_self()<<"  Declare node:"<<ir<<"\n";
+         }  
+         nf->copy(p);
+         nf->addRef();
+      } else {
+         nf = new PFSNode(p); 
+      }
+
+      nf->Fixe(j,*inst);
+      if ( nf->perm().isallfixed() ) {
+         nf->setSol();
+         //std::cout << "Solution :"<<nf->getCost()<<std::endl;
+         //nf->Prt(std::cout);
+      }
+      nf->dist()++;
+      fl+=Search(nf);
    }
    return fl;
 }
@@ -55,6 +55,13 @@ A Branch and bound is used to exactly solve some quite large instances.
 */
 
 
+#ifndef PFS_MAXJ
+/// the maximum number of jobs of an instance
+#define PFS_MAXJ 200
+#endif
+/// the permutation of the jobs stored in a node
+typedef Bob::CPermutation<PFS_MAXJ> PFSPerm;
+
 class PFSInstance;
 class PFSNode;
 class PFSGenChild;
@@ -92,7 +99,7 @@ class PFSNode : public Bob::CDCIntMinNode {
 protected:
 int nbj;
 int nbm;
-Bob::Permutation per;
+PFSPerm per;
 MachineDate md;
 public:
     /// Contructor
@@ -124,7 +131,7 @@ public:
     /// Fixe the job i
     void Fixe(int i,const PFSInstance &pfi);
     /// get the permutation
-    Bob::Permutation &perm() { return per; }
+    PFSPerm &perm() { return per; }
     /// get the MachineDate 
     MachineDate &macdate() { return md; }
     /// Pack method to serialize the BobNode
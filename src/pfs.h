@@ -16,6 +16,8 @@
 
 #include <string>
 #include <vector>
+#include <cmath>
+#include <cfloat>
 #include <Eigen/unsupported/Eigen/MatrixFunctions>
 #include <Eigen/Core>
 #include <Eigen/Dense>
@@ -105,6 +107,12 @@ int nbj;
 int nbm;
 Bob::Permutation per;
 Scheduled sc;
+/// test if a value could be stored as a float
+static bool fitf(double x) { return fabs(x) < FLT_MAX/2; }
+/// get the greatest float lower than or equal to x
+static float downf(double x) { float f = x; return (f > x ? nextafterf(f,-FLT_MAX) : f); }
+/// get the lowest float greater than or equal to x
+static float upf(double x) { float f = x; return (f < x ? nextafterf(f,FLT_MAX) : f); }
 
 public:
     double x1LB;  // parent node VaR value as the x1 for bisection of child node
@@ -175,6 +183,54 @@ public:
        Bob::UnPack(bs,&per);
        Bob::UnPack(bs,&sc);
     }
+    /** Pack method used by the compact priority queue (see Bob::PQCompact).
+      * Only the jobs fixed at the beginning and at the end of the permutation are stored,
+      * the integers are stored with a variable width. The bounds of the bisection are
+      * stored as floats rounded outward, the bracket could only be wider.
+      * The Scheduled has no state to store (see Scheduled::Pack).
+      */
+    virtual void PackQ(Bob::Serialize &bs)  const {
+       int nr = per.getLocR()+1, nd = (per.getLocD()<0 ? 0 : nbj-per.getLocD());
+       int q = (fitf(x1LB) && fitf(x2UB) ? 1 : 0);
+       int h[7] = { d, b, nbj, nbm, nr, nd, q };
+       double e = getEval();
+       std::vector<int> j(nr+nd+1);
+       bs.PackVar(h,7);
+       bs.Pack(&nid,1);
+       bs.Pack(&e,1);
+       if ( q ) {
+          float f[2] = { downf(x1LB), upf(x2UB) };
+          bs.Pack(f,2);
+       } else {
+          bs.Pack(&x1LB,1);
+          bs.Pack(&x2UB,1);
+       }
+       for (int i=0;i<nr;i++) j[i] = per.geti(i);
+       for (int i=0;i<nd;i++) j[nr+i] = per.geti(nbj-1-i);
+       bs.PackVar(&j[0],nr+nd);
+    }
+    /// Unpack method used by the compact priority queue
+    virtual void UnPackQ(Bob::DeSerialize &bs)  {
+       int h[7];
+       double e;
+       bs.UnPackVar(h,7);
+       bs.UnPack(&nid,1);
+       bs.UnPack(&e,1);
+       _ref = 0; d = h[0]; b = h[1]; nbj = h[2]; nbm = h[3]; setEval(e);
+       if ( h[6] ) {
+          float f[2];
+          bs.UnPack(f,2);
+          x1LB = f[0]; x2UB = f[1];
+       } else {
+          bs.UnPack(&x1LB,1);
+          bs.UnPack(&x2UB,1);
+       }
+       std::vector<int> j(h[4]+h[5]+1);
+       bs.UnPackVar(&j[0],h[4]+h[5]);
+       per = Bob::Permutation(nbj);
+       for (int i=0;i<h[4];i++) per.fixeR(j[i]);
+       for (int i=0;i<h[5];i++) per.fixeD(j[h[4]+i]);
+    }
 
     /// evaluate the node
     void eval(const PFSInstance *pfi,double minCost, double x1LB, double x2UB);